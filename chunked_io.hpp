@@ -0,0 +1,503 @@
+#pragma once
+
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include "io_tools.hpp"
+
+// The container of 'chunked_ofstream': a header, the compressed chunks and
+// the index of the chunks (offset and size of every chunk) at the end of
+// the file. The values of an element are stored as separate streams of
+// doubles; each stream is delta coded, byte shuffled and packed with a
+// small LZ77 codec. FLOAT32 rounds the values to float, QUANTIZED rounds
+// them to the multiples of 2 * error_bound.
+enum chunk_mode_t : std::uint32_t
+{
+	LOSSLESS = 0,
+	FLOAT32 = 1,
+	QUANTIZED = 2
+};
+
+struct chunked_header
+{
+	char magic[8];
+	std::uint32_t version, element_size, mode, reserved;
+	double error_bound;
+	std::uint64_t count, chunk_elements, chunks, index_offset;
+};
+
+struct chunk_entry
+{
+	std::uint64_t offset, size;
+};
+
+const char CHUNKED_MAGIC[8] = { 'C', 'H', 'U', 'N', 'K', 'D', 'A', 'T' };
+
+inline void put_varint(std::vector<std::uint8_t> &out, std::uint64_t v)
+{
+	while (v >= 0x80)
+	{
+		out.push_back((std::uint8_t)(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back((std::uint8_t)v);
+}
+
+inline std::uint64_t get_varint(const std::uint8_t *&p, const std::uint8_t *end)
+{
+	std::uint64_t v = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (p == end)
+			throw std::runtime_error("Chunk is truncated.");
+		const auto byte = *p++;
+		v |= (std::uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return v;
+	}
+	throw std::runtime_error("Chunk is corrupted.");
+}
+
+inline void lz_compress(const std::vector<std::uint8_t> &in, std::vector<std::uint8_t> &out)
+{
+	const std::size_t n = in.size();
+	std::vector<std::uint32_t> table(1 << 16, 0);
+
+	const auto emit = [&](const std::size_t first, const std::size_t last)
+	{
+		put_varint(out, last - first);
+		out.insert(out.end(), in.begin() + first, in.begin() + last);
+	};
+
+	std::size_t anchor = 0, pos = 0;
+	while (pos + 4 <= n)
+	{
+		std::uint32_t word;
+		std::memcpy(&word, &in[pos], 4);
+		const std::uint32_t h = (word * 2654435761U) >> 16;
+		const std::size_t candidate = table[h];
+		table[h] = (std::uint32_t)(pos + 1);
+		if (candidate == 0 || std::memcmp(&in[candidate - 1], &in[pos], 4) != 0)
+		{
+			++pos;
+			continue;
+		}
+
+		const std::size_t from = candidate - 1;
+		std::size_t len = 4;
+		while (pos + len < n && in[from + len] == in[pos + len])
+			++len;
+		emit(anchor, pos);
+		put_varint(out, len);
+		put_varint(out, pos - from);
+		pos += len;
+		anchor = pos;
+	}
+	emit(anchor, n);
+	put_varint(out, 0);
+}
+
+inline void lz_decompress(
+	const std::uint8_t *&p,
+	const std::uint8_t *end,
+	std::vector<std::uint8_t> &out
+) {
+	for (;;)
+	{
+		const auto literals = get_varint(p, end);
+		if ((std::uint64_t)(end - p) < literals)
+			throw std::runtime_error("Chunk is truncated.");
+		out.insert(out.end(), p, p + literals);
+		p += literals;
+
+		const auto len = get_varint(p, end);
+		if (len == 0)
+			return;
+		const auto offset = get_varint(p, end);
+		if (offset == 0 || offset > out.size())
+			throw std::runtime_error("Chunk is corrupted.");
+		for (std::size_t i = out.size() - offset, k = 0; k < len; ++k)
+			out.push_back(out[i + k]);
+	}
+}
+
+// Differences of neighbouring words (zigzag coded) with the bytes of equal
+// significance gathered together: smooth data gives long runs of zeros.
+template<class W>
+void encode_words(std::vector<W> &words, std::vector<std::uint8_t> &out)
+{
+	using S = typename std::make_signed<W>::type;
+	const std::size_t n = words.size();
+	for (std::size_t i = n; i-- > 1;)
+	{
+		const auto d = (S)(words[i] - words[i - 1]);
+		words[i] = ((W)d << 1) ^ (W)(d >> (8 * sizeof(W) - 1));
+	}
+
+	std::vector<std::uint8_t> bytes(n * sizeof(W));
+	for (std::size_t i = 0; i < n; ++i)
+		for (std::size_t b = 0; b < sizeof(W); ++b)
+			bytes[b * n + i] = (std::uint8_t)(words[i] >> (8 * b));
+	lz_compress(bytes, out);
+}
+
+template<class W>
+void decode_words(
+	const std::uint8_t *&p,
+	const std::uint8_t *end,
+	std::vector<W> &words
+) {
+	const std::size_t n = words.size();
+	std::vector<std::uint8_t> bytes;
+	bytes.reserve(n * sizeof(W));
+	lz_decompress(p, end, bytes);
+	if (bytes.size() != n * sizeof(W))
+		throw std::runtime_error("Chunk is corrupted.");
+
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		W w = 0;
+		for (std::size_t b = 0; b < sizeof(W); ++b)
+			w |= (W)bytes[b * n + i] << (8 * b);
+		words[i] = i == 0 ? w : words[i - 1] + ((w >> 1) ^ (W)-(w & 1));
+	}
+}
+
+// Packs the values of a chunk (component-major order) into 'out'.
+inline void encode_chunk(
+	const std::vector<double> &data,
+	const chunk_mode_t mode,
+	const double error_bound,
+	std::vector<std::uint8_t> &out
+) {
+	const std::size_t n = data.size();
+	switch (mode)
+	{
+	case LOSSLESS:
+	{
+		std::vector<std::uint64_t> words(n);
+		std::memcpy(words.data(), data.data(), n * sizeof(double));
+		encode_words(words, out);
+		break;
+	}
+
+	case FLOAT32:
+	{
+		std::vector<std::uint32_t> words(n);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			const float x = (float)data[i];
+			std::memcpy(&words[i], &x, sizeof(float));
+		}
+		encode_words(words, out);
+		break;
+	}
+
+	case QUANTIZED:
+	{
+		const double step = 2 * error_bound, limit = 4e18;
+		std::vector<std::uint64_t> words(n);
+		std::vector<std::size_t> exceptions;
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			const double q = std::round(data[i] / step);
+			if (std::isfinite(q) && std::abs(q) < limit)
+				words[i] = (std::uint64_t)(std::int64_t)q;
+			else
+			{
+				words[i] = i > 0 ? words[i - 1] : 0;
+				exceptions.push_back(i);
+			}
+		}
+		put_varint(out, exceptions.size());
+		for (const auto i : exceptions)
+		{
+			put_varint(out, i);
+			const auto *bytes = (const std::uint8_t*)&data[i];
+			out.insert(out.end(), bytes, bytes + sizeof(double));
+		}
+		encode_words(words, out);
+		break;
+	}
+	}
+}
+
+inline void decode_chunk(
+	const std::uint8_t *p,
+	const std::uint8_t *end,
+	const chunk_mode_t mode,
+	const double error_bound,
+	std::vector<double> &data
+) {
+	const std::size_t n = data.size();
+	switch (mode)
+	{
+	case LOSSLESS:
+	{
+		std::vector<std::uint64_t> words(n);
+		decode_words(p, end, words);
+		std::memcpy(data.data(), words.data(), n * sizeof(double));
+		break;
+	}
+
+	case FLOAT32:
+	{
+		std::vector<std::uint32_t> words(n);
+		decode_words(p, end, words);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			float x;
+			std::memcpy(&x, &words[i], sizeof(float));
+			data[i] = x;
+		}
+		break;
+	}
+
+	case QUANTIZED:
+	{
+		const double step = 2 * error_bound;
+		const auto count = get_varint(p, end);
+		if (count > n)
+			throw std::runtime_error("Chunk is corrupted.");
+		std::vector<std::pair<std::size_t, double>> exceptions(count);
+		for (auto &e : exceptions)
+		{
+			e.first = get_varint(p, end);
+			if (e.first >= n || end - p < (std::ptrdiff_t)sizeof(double))
+				throw std::runtime_error("Chunk is corrupted.");
+			std::memcpy(&e.second, p, sizeof(double));
+			p += sizeof(double);
+		}
+		std::vector<std::uint64_t> words(n);
+		decode_words(p, end, words);
+		for (std::size_t i = 0; i < n; ++i)
+			data[i] = (double)(std::int64_t)words[i] * step;
+		for (const auto &e : exceptions)
+			data[e.first] = e.second;
+		break;
+	}
+
+	default:
+		throw std::runtime_error("Unknown chunk mode.");
+	}
+}
+
+template<class T>
+class chunked_ofstream : public std::ofstream
+{
+private:
+	static_assert(sizeof(T) % sizeof(double) == 0, "T must consist of doubles.");
+	static const std::size_t components = sizeof(T) / sizeof(double);
+
+	chunked_header header;
+	std::vector<chunk_entry> index;
+	std::vector<T> pending;
+	unsigned int threads;
+
+	// Compresses the elements [arg, arg + count) by chunks (all but the last
+	// one whole), a batch of 'threads' chunks in parallel at a time, and
+	// appends every batch to the file before the next one is compressed.
+	void __write__(const T *arg, const std::size_t count)
+	{
+		const std::size_t size = header.chunk_elements;
+		const std::size_t chunks = (count + size - 1) / size;
+		std::vector<std::vector<std::uint8_t>> buffers(std::min<std::size_t>(threads, chunks));
+		for (std::size_t batch = 0; batch < chunks; batch += buffers.size())
+		{
+			const std::size_t batch_end = std::min(batch + buffers.size(), chunks);
+			std::atomic<std::size_t> next(batch);
+			const auto worker = [&]()
+			{
+				std::vector<double> data;
+				for (std::size_t k; (k = next.fetch_add(1)) < batch_end;)
+				{
+					const std::size_t first = k * size, last = std::min(first + size, count);
+					const auto *values = (const double*)(arg + first);
+					data.resize((last - first) * components);
+					for (std::size_t c = 0; c < components; ++c)
+						for (std::size_t i = 0; i < last - first; ++i)
+							data[c * (last - first) + i] = values[i * components + c];
+					buffers[k - batch].clear();
+					encode_chunk(data, (chunk_mode_t)header.mode, header.error_bound, buffers[k - batch]);
+				}
+			};
+
+			std::vector<std::thread> pool;
+			for (std::size_t i = 1; i < batch_end - batch; ++i)
+				pool.emplace_back(worker);
+			worker();
+			for (auto &thr : pool)
+				thr.join();
+
+			for (std::size_t k = 0; k < batch_end - batch; ++k)
+			{
+				index.push_back({ (std::uint64_t)tellp(), buffers[k].size() });
+				std::ofstream::write((const char*)buffers[k].data(), buffers[k].size());
+			}
+		}
+		header.count += count;
+	}
+
+public:
+	chunked_ofstream() : std::ofstream(), header(), threads(1) {}
+
+	~chunked_ofstream()
+	{
+		if (is_open())
+			close();
+	}
+
+	void open(
+		const std::string &file,
+		const chunk_mode_t mode = LOSSLESS,
+		const double error_bound = 0,
+		const std::size_t chunk_elements = 1 << 16,
+		const unsigned int tt = 0
+	) {
+		header = chunked_header();
+		std::memcpy(header.magic, CHUNKED_MAGIC, sizeof(header.magic));
+		header.version = 1;
+		header.element_size = sizeof(T);
+		header.mode = mode;
+		header.error_bound = error_bound;
+		header.chunk_elements = std::max<std::size_t>(chunk_elements, 1);
+		index.clear();
+		pending.clear();
+		threads = tt > 0 ? tt : std::max(std::thread::hardware_concurrency(), 1U);
+
+		std::ofstream::open(file, std::ios::out | std::ios::binary | std::ios::trunc);
+		write_binary(*this, header);
+	}
+
+	// Small writes are gathered into a batch of 'threads' chunks, the whole
+	// chunks of a large one are compressed from 'arg' without a copy.
+	template<class A>
+	auto &write_vector(const std::vector<T, A> &arg)
+	{
+		const std::size_t size = header.chunk_elements, batch = threads * size;
+		std::size_t first = 0;
+		if (!pending.empty() || arg.size() < batch)
+		{
+			first = std::min(batch - pending.size(), arg.size());
+			pending.insert(pending.end(), arg.begin(), arg.begin() + first);
+			if (pending.size() < batch)
+				return *this;
+			__write__(pending.data(), pending.size());
+			pending.clear();
+		}
+		const std::size_t whole = (arg.size() - first) / size * size;
+		__write__(arg.data() + first, whole);
+		pending.assign(arg.begin() + first + whole, arg.end());
+		return *this;
+	}
+
+	void close()
+	{
+		__write__(pending.data(), pending.size());
+		pending.clear();
+		header.chunks = index.size();
+		header.index_offset = tellp();
+		for (const auto &entry : index)
+			write_binary(*this, entry);
+		seekp(0);
+		write_binary(*this, header);
+		std::ofstream::close();
+	}
+};
+
+template<class T>
+class chunked_ifstream : public std::ifstream
+{
+private:
+	static_assert(sizeof(T) % sizeof(double) == 0, "T must consist of doubles.");
+	static const std::size_t components = sizeof(T) / sizeof(double);
+
+	chunked_header header;
+	std::vector<chunk_entry> index;
+
+public:
+	chunked_ifstream() : std::ifstream(), header() {}
+
+	chunked_ifstream(const std::string &file) : chunked_ifstream()
+	{
+		open(file);
+	}
+
+	void open(const std::string &file)
+	{
+		std::ifstream::open(file, std::ios::in | std::ios::binary);
+		if (
+			!read_binary(*this, header) ||
+			std::memcmp(header.magic, CHUNKED_MAGIC, sizeof(header.magic)) != 0 ||
+			header.element_size != sizeof(T)
+		) {
+			setstate(std::ios::failbit);
+			return;
+		}
+		index.resize(header.chunks);
+		seekg(header.index_offset);
+		for (auto &entry : index)
+			read_binary(*this, entry);
+	}
+
+	inline std::size_t size() const
+	{
+		return header.count;
+	}
+
+	inline chunk_mode_t mode() const
+	{
+		return (chunk_mode_t)header.mode;
+	}
+
+	// Reads the elements [first, first + arg.size()), only the chunks which
+	// contain them are decompressed.
+	auto &read_range(const std::size_t first, std::vector<T> &arg)
+	{
+		const std::size_t size = header.chunk_elements, last = first + arg.size();
+		if (last > header.count)
+			throw std::out_of_range("The range is out of the file.");
+
+		std::vector<std::uint8_t> buffer;
+		std::vector<double> data;
+		for (std::size_t k = first / size; k * size < last; ++k)
+		{
+			const std::size_t c_first = k * size;
+			const std::size_t c_count = std::min<std::size_t>(size, header.count - c_first);
+			buffer.resize(index[k].size);
+			seekg(index[k].offset);
+			std::ifstream::read((char*)buffer.data(), buffer.size());
+			if (!*this)
+				break;
+			data.resize(c_count * components);
+			decode_chunk(
+				buffer.data(), buffer.data() + buffer.size(),
+				(chunk_mode_t)header.mode, header.error_bound, data
+			);
+
+			const std::size_t i_first = std::max(first, c_first);
+			const std::size_t i_last = std::min(last, c_first + c_count);
+			for (std::size_t i = i_first; i < i_last; ++i)
+			{
+				auto *values = (double*)&arg[i - first];
+				for (std::size_t c = 0; c < components; ++c)
+					values[c] = data[c * c_count + (i - c_first)];
+			}
+		}
+		return *this;
+	}
+
+	auto &read_vector(std::vector<T> &arg)
+	{
+		arg.resize(header.count);
+		return read_range(0, arg);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <algorithm>
+#include "linear_fractional_transformation.hpp"
+#include "numeric_tools.hpp"
+#include "memory_tools.hpp"
+
+// The same series as 'theta_series', but members are grouped into a tree
+// of clusters by the location of their poles. A cluster which is far from
+// the point is replaced by the truncated Laurent expansion of its sum about
+// the cluster center, near clusters are opened up to the exact members.
+template<class T>
+class clustered_theta_series
+{
+private:
+	using real = decltype(std::abs(T()));
+
+	struct member_t
+	{
+		linear_fractional_transformation<T> f;
+		T c, d;
+		T location;
+		real extent;
+		std::size_t index;
+		member_t() : f(), c(), d(), location(), extent(), index() {}
+		member_t(
+			const linear_fractional_transformation<T> &ff,
+			const T cc, const T dd,
+			const std::size_t ii
+		) : f(ff), c(cc), d(dd), location(), extent(), index(ii) {}
+	};
+
+	struct cluster_t
+	{
+		T center;
+		real radius;
+		std::size_t first, last;
+		std::size_t left, right;
+		std::vector<T> coefficients;
+		cluster_t() : center(), radius(), first(), last(), left(), right() {}
+	};
+
+	huge_page_vector<member_t> members;
+	huge_page_vector<member_t> direct;
+	std::vector<cluster_t> clusters;
+	// The member k of the list given to 'build' is direct[positions[k]] or
+	// members[positions[k] - direct.size()].
+	std::vector<std::size_t> positions;
+
+	unsigned int m;
+
+	unsigned int order, leaf_size;
+	real separation;
+
+	inline auto term(const member_t &member, const T z) const
+	{
+		return member.f(z) * int_pow(member.c * z + member.d, -2 * m);
+	}
+
+	inline auto direct_sum(
+		const std::size_t first,
+		const std::size_t last,
+		const T z
+	) const {
+		T w = 0;
+		for (std::size_t i = first; i < last; ++i)
+			w += term(members[i], z);
+		return w;
+	}
+
+	std::size_t __split__(const std::size_t first, const std::size_t last)
+	{
+		const std::size_t index = clusters.size();
+		clusters.emplace_back();
+
+		real x_min = INFINITY, x_max = -INFINITY, y_min = INFINITY, y_max = -INFINITY;
+		for (std::size_t i = first; i < last; ++i)
+		{
+			const auto p = members[i].location;
+			x_min = std::min(x_min, p.real()); x_max = std::max(x_max, p.real());
+			y_min = std::min(y_min, p.imag()); y_max = std::max(y_max, p.imag());
+		}
+		const T center((x_min + x_max) / 2, (y_min + y_max) / 2);
+		real radius = 0;
+		for (std::size_t i = first; i < last; ++i)
+			radius = std::max(radius, std::abs(members[i].location - center) + members[i].extent);
+		radius = std::max(radius, (real)EPSILON * (1 + std::abs(center)));
+
+		std::size_t left = 0, right = 0;
+		if (last - first > leaf_size)
+		{
+			const std::size_t middle = first + (last - first) / 2;
+			const bool by_x = x_max - x_min >= y_max - y_min;
+			std::nth_element(
+				members.begin() + first,
+				members.begin() + middle,
+				members.begin() + last,
+				[by_x](const member_t &u, const member_t &v)
+				{
+					return by_x
+						? u.location.real() < v.location.real()
+						: u.location.imag() < v.location.imag();
+				}
+			);
+			left = __split__(first, middle);
+			right = __split__(middle, last);
+		}
+
+		auto &cluster = clusters[index];
+		cluster.center = center;
+		cluster.radius = radius;
+		cluster.first = first;
+		cluster.last = last;
+		cluster.left = left;
+		cluster.right = right;
+		return index;
+	}
+
+	// The Laurent coefficients a_1, ..., a_p of the cluster sum about its
+	// center are computed by the trapezoidal rule on the circle of radius
+	// 2 * radius, so the aliasing error is of order 2^{-2p}.
+	void __expand__(cluster_t &cluster) const
+	{
+		const std::size_t count = 2 * order;
+		const real rho = 2 * cluster.radius;
+
+		std::vector<T> samples(count);
+		for (std::size_t j = 0; j < count; ++j)
+		{
+			const real phi = 2 * (real)PI * j / count;
+			const T u(rho * std::cos(phi), rho * std::sin(phi));
+			samples[j] = u * direct_sum(cluster.first, cluster.last, cluster.center + u);
+		}
+
+		cluster.coefficients.assign(order, T(0));
+		for (std::size_t j = 0; j < count; ++j)
+		{
+			const real phi = 2 * (real)PI * j / count;
+			const T u(rho * std::cos(phi), rho * std::sin(phi));
+			auto q = samples[j] / (real)count;
+			for (auto &a : cluster.coefficients)
+			{
+				a += q;
+				q *= u;
+			}
+		}
+	}
+
+	void __build__()
+	{
+		huge_page_vector<member_t> clustered;
+		clustered.reserve(members.size());
+		direct.clear();
+		for (auto &member : members)
+		{
+			const auto scale = std::abs(member.c) + std::abs(member.d);
+			const auto f_scale = std::abs(member.f.c) + std::abs(member.f.d);
+			if (std::abs(member.c) <= EPSILON * scale || std::abs(member.f.c) <= EPSILON * f_scale)
+			{
+				direct.push_back(member);
+				continue;
+			}
+			const auto p1 = -member.d / member.c, p2 = -member.f.d / member.f.c;
+			member.location = (p1 + p2) / (real)2;
+			member.extent = std::abs(p1 - p2) / 2;
+			clustered.push_back(member);
+		}
+		members = std::move(clustered);
+
+		clusters.clear();
+		if (!members.empty())
+		{
+			__split__(0, members.size());
+			for (auto &cluster : clusters)
+				if (cluster.last - cluster.first > order)
+					__expand__(cluster);
+		}
+
+		positions.resize(direct.size() + members.size());
+		for (std::size_t i = 0; i < direct.size(); ++i)
+			positions[direct[i].index] = i;
+		for (std::size_t i = 0; i < members.size(); ++i)
+			positions[members[i].index] = direct.size() + i;
+	}
+
+	T __evaluate__(const std::size_t index, const T z) const
+	{
+		const auto &cluster = clusters[index];
+		const auto count = cluster.last - cluster.first;
+		const auto far = std::abs(z - cluster.center) > separation * cluster.radius;
+
+		if (far && count > order)
+		{
+			const auto u = (real)1 / (z - cluster.center);
+			T w = 0;
+			for (auto it = cluster.coefficients.rbegin(); it != cluster.coefficients.rend(); ++it)
+				w = (w + *it) * u;
+			return w;
+		}
+		if (far || cluster.left == 0)
+			return direct_sum(cluster.first, cluster.last, z);
+		return __evaluate__(cluster.left, z) + __evaluate__(cluster.right, z);
+	}
+
+public:
+	clustered_theta_series(
+		const unsigned int oo = 40,
+		const unsigned int ll = 16,
+		const real ss = 4
+	) : m(0), order(oo), leaf_size(ll), separation(ss) {}
+
+	template<class U, class V>
+	clustered_theta_series(
+		const unsigned int mm,
+		const linear_fractional_transformation<U> &h,
+		const std::vector<linear_fractional_transformation<V>> &G
+	) : clustered_theta_series()
+	{
+		build(mm, h, G);
+	}
+
+	template<class U, class V>
+	void build(
+		const unsigned int mm,
+		const linear_fractional_transformation<U> &h,
+		const std::vector<linear_fractional_transformation<V>> &G
+	) {
+		m = mm;
+		members.clear();
+		members.reserve(G.size());
+		for (const auto &g : G)
+			members.emplace_back(h * g, g.c, g.d, members.size());
+		__build__();
+	}
+
+	template<class U>
+	inline auto operator()(const U z) const
+	{
+		T w = 0;
+		for (const auto &member : direct)
+			w += term(member, z);
+		if (!clusters.empty())
+			w += __evaluate__(0, z);
+		return w;
+	}
+
+	// The partial sum over the members [first, last) of the list given to
+	// 'build'. The terms are summed exactly, without the expansions.
+	template<class U>
+	inline auto operator()(const U z, const std::size_t first, const std::size_t last) const
+	{
+		T w = 0;
+		for (std::size_t k = first; k < std::min(last, positions.size()); ++k)
+		{
+			const std::size_t p = positions[k];
+			w += term(p < direct.size() ? direct[p] : members[p - direct.size()], z);
+		}
+		return w;
+	}
+
+	template<class U>
+	inline auto map(const U &zz) const
+	{
+		U ww = zz;
+		for (auto &e : ww) e = operator()(e);
+		return ww;
+	}
+
+	template<class U>
+	inline auto transform(U &zz) const
+	{
+		for (auto &z : zz) z = operator()(z);
+		return zz;
+	}
+
+	inline std::size_t members_count() const
+	{
+		return members.size() + direct.size();
+	}
+
+	inline std::size_t clusters_count() const
+	{
+		return clusters.size();
+	}
+};
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cmath>
+#include <complex>
+
+// A complex number with the plain formulas of the arithmetic: the product
+// has no recovery of infinite and NaN results (C99 Annex G, '__muldc3') and
+// the quotient is the product by the reciprocal of the divisor instead of
+// '__divdc3'. It is a 'std::complex', so the functions of <complex> and the
+// mixed operations with 'std::complex' still apply; the operations of two
+// 'fast_complex' or of a 'fast_complex' and a real number are these ones.
+template<class T>
+class fast_complex : public std::complex<T>
+{
+private:
+	using base = std::complex<T>;
+
+public:
+	constexpr fast_complex(const T x = T(), const T y = T()) : base(x, y) {}
+
+	template<class U>
+	constexpr fast_complex(const std::complex<U> &z) : base(z.real(), z.imag()) {}
+
+	inline fast_complex &operator+=(const fast_complex &z)
+	{
+		return *this = *this + z;
+	}
+
+	inline fast_complex &operator-=(const fast_complex &z)
+	{
+		return *this = *this - z;
+	}
+
+	inline fast_complex &operator*=(const fast_complex &z)
+	{
+		return *this = *this * z;
+	}
+
+	inline fast_complex &operator/=(const fast_complex &z)
+	{
+		return *this = *this / z;
+	}
+
+	inline fast_complex &operator*=(const T x)
+	{
+		return *this = *this * x;
+	}
+
+	inline fast_complex &operator/=(const T x)
+	{
+		return *this = *this / x;
+	}
+
+	friend inline fast_complex operator-(const fast_complex &z)
+	{
+		return fast_complex(-z.real(), -z.imag());
+	}
+
+	friend inline fast_complex operator+(const fast_complex &z, const fast_complex &w)
+	{
+		return fast_complex(z.real() + w.real(), z.imag() + w.imag());
+	}
+
+	friend inline fast_complex operator-(const fast_complex &z, const fast_complex &w)
+	{
+		return fast_complex(z.real() - w.real(), z.imag() - w.imag());
+	}
+
+	friend inline fast_complex operator*(const fast_complex &z, const fast_complex &w)
+	{
+		return fast_complex(
+			z.real() * w.real() - z.imag() * w.imag(),
+			z.real() * w.imag() + z.imag() * w.real()
+		);
+	}
+
+	friend inline fast_complex operator/(const fast_complex &z, const fast_complex &w)
+	{
+		return z * reciprocal(w);
+	}
+
+	friend inline fast_complex operator+(const fast_complex &z, const T x)
+	{
+		return fast_complex(z.real() + x, z.imag());
+	}
+
+	friend inline fast_complex operator+(const T x, const fast_complex &z)
+	{
+		return fast_complex(x + z.real(), z.imag());
+	}
+
+	friend inline fast_complex operator-(const fast_complex &z, const T x)
+	{
+		return fast_complex(z.real() - x, z.imag());
+	}
+
+	friend inline fast_complex operator-(const T x, const fast_complex &z)
+	{
+		return fast_complex(x - z.real(), -z.imag());
+	}
+
+	friend inline fast_complex operator*(const fast_complex &z, const T x)
+	{
+		return fast_complex(z.real() * x, z.imag() * x);
+	}
+
+	friend inline fast_complex operator*(const T x, const fast_complex &z)
+	{
+		return fast_complex(x * z.real(), x * z.imag());
+	}
+
+	friend inline fast_complex operator/(const fast_complex &z, const T x)
+	{
+		const T r = T(1) / x;
+		return fast_complex(z.real() * r, z.imag() * r);
+	}
+
+	friend inline fast_complex operator/(const T x, const fast_complex &z)
+	{
+		return x * reciprocal(z);
+	}
+
+	// 1 / z = conj(z) / |z|^2, the parts are divided by the larger of their
+	// absolute values first, so |z|^2 neither overflows nor underflows. This
+	// is the inverse of the factor c z + d of the terms of the series.
+	friend inline fast_complex reciprocal(const fast_complex &z)
+	{
+		const T s = T(1) / std::fmax(std::fabs(z.real()), std::fabs(z.imag()));
+		const T x = z.real() * s, y = z.imag() * s;
+		const T r = s / (x * x + y * y);
+		return fast_complex(x * r, -y * r);
+	}
+};
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <fstream>
 #include <vector>
 #include <string>
+#include <cstdint>
 //#include <complex>
 //#include <typeinfo>
 //#include <type_traits>
@@ -225,7 +226,8 @@ public:
 		return std::ofstream::write((char*)(&arg), sizeof(T));
 	}
 
-	auto &write_vector(const std::vector<T> &arg)
+	template<class A>
+	auto &write_vector(const std::vector<T, A> &arg)
 	{
 		/*static_assert(
 			std::is_same<T, typename U::value_type>::value,
@@ -234,4 +236,36 @@ public:
 		);//*/
 		return std::ofstream::write((char*)arg.data(), sizeof(T) * arg.size());
 	}
-};
\ No newline at end of file
+};
+
+template<class T>
+inline std::ostream &write_binary(std::ostream &out, const T &arg)
+{
+	return out.write((const char*)(&arg), sizeof(T));
+}
+
+template<class T>
+inline std::istream &read_binary(std::istream &in, T &arg)
+{
+	return in.read((char*)(&arg), sizeof(T));
+}
+
+template<class T>
+std::ostream &write_sized_vector(std::ostream &out, const std::vector<T> &arg)
+{
+	const std::uint64_t size = arg.size();
+	write_binary(out, size);
+	return out.write((const char*)arg.data(), sizeof(T) * arg.size());
+}
+
+template<class T>
+std::istream &read_sized_vector(std::istream &in, std::vector<T> &arg)
+{
+	std::uint64_t size = 0;
+	if (read_binary(in, size))
+	{
+		arg.resize(size);
+		in.read((char*)arg.data(), sizeof(T) * arg.size());
+	}
+	return in;
+}
\ No newline at end of file
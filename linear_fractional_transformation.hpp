@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cmath>
+#include <complex>
+#include "numeric_tools.hpp"
 
 template<class T>
 class linear_fractional_transformation
@@ -17,6 +19,11 @@ public:
 		const T3 cc,
 		const T4 dd
 	) : a(aa), b(bb), c(cc), d(dd) {}
+
+	// The same transformation with the coefficients of another type.
+	template<class U>
+	explicit linear_fractional_transformation(const linear_fractional_transformation<U> &f)
+		: a(f.a), b(f.b), c(f.c), d(f.d) {}
 	
 	template<class U>
 	inline auto operator*(const linear_fractional_transformation<U> &other) const
@@ -134,4 +141,90 @@ inline auto Euclidean_distance(
 		cc = std::abs(f.c - g.c),
 		dd = std::abs(f.d - g.d);
 	return std::sqrt(aa * aa + bb * bb + cc * cc + dd * dd);
+}
+
+// A transformation with the matrix of determinant 1 and the fixed one of the
+// two signs of the matrix: the first of the real and imaginary parts of
+// a, b, c, d which is not negligible is positive. Equal transformations
+// have then (up to rounding) equal coefficients.
+template<class T>
+class normalized_transformation : public linear_fractional_transformation<T>
+{
+private:
+	using base = linear_fractional_transformation<T>;
+
+	inline void __canonize__()
+	{
+		const auto tolerance = std::sqrt(EPSILON) * base::Euclidean_norm();
+		for (const auto x : { base::a, base::b, base::c, base::d })
+			for (const auto y : { std::real(x), std::imag(x) })
+				if (std::abs(y) > tolerance)
+				{
+					if (y < 0)
+					{
+						base::a = -base::a; base::b = -base::b;
+						base::c = -base::c; base::d = -base::d;
+					}
+					return;
+				}
+	}
+
+	// The coefficients of a product of matrices of determinant 1 have the
+	// determinant 1 + e with small e, (3 - det) / 2 = 1 / sqrt(det) + O(e^2).
+	inline void __renormalize__()
+	{
+		const auto k = ((T)3 - base::det()) / (T)2;
+		base::a *= k; base::b *= k; base::c *= k; base::d *= k;
+	}
+
+	struct raw_t {};
+
+	normalized_transformation(const base &f, raw_t) : base(f) {}
+
+public:
+	normalized_transformation() : base() {}
+
+	template<class U>
+	normalized_transformation(const linear_fractional_transformation<U> &f) : base(f.cancel_out())
+	{
+		__canonize__();
+	}
+
+	template<class T1, class T2, class T3, class T4>
+	normalized_transformation(
+		const T1 aa,
+		const T2 bb,
+		const T3 cc,
+		const T4 dd
+	) : normalized_transformation(base(aa, bb, cc, dd)) {}
+
+	inline auto operator*(const normalized_transformation &other) const
+	{
+		normalized_transformation f(base::operator*(other), raw_t());
+		f.__renormalize__();
+		f.__canonize__();
+		return f;
+	}
+
+	inline auto inverse() const
+	{
+		normalized_transformation f(base::inverse(), raw_t());
+		f.__canonize__();
+		return f;
+	}
+
+	// A cheap key of the coefficients: transformations at the Euclidean
+	// distance at most 'eps' have keys at the distance at most 4 * 'eps'.
+	inline auto key() const
+	{
+		return std::real(base::a) + std::imag(base::b) + std::real(base::c) + std::imag(base::d);
+	}
+};
+
+template<class T, class U>
+inline bool operator==(
+	const normalized_transformation<T> &f,
+	const normalized_transformation<U> &g
+) {
+	return equal_coefficients(f, g);
 }
\ No newline at end of file
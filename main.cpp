@@ -1,53 +1,1093 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <complex>
 #include <vector>
 #include <string>
+#include <map>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <array>
+#include <stdexcept>
 #include "linear_fractional_transformation.hpp"
 #include "solution.hpp"
+#include "clustered_theta_series.hpp"
 #include "io_tools.hpp"
+#include "chunked_io.hpp"
+#include "visualization_tools.hpp"
+#include "process_tools.hpp"
+#include "mapped_file.hpp"
+#include "memory_tools.hpp"
+#include "problem.hpp"
+#include "task_graph.hpp"
 
 using real = double;
 using complex = std::complex<real>;
 using transform = linear_fractional_transformation<complex>;
 
+#if defined(CLUSTERED_THETA_SERIES)
+template<class T> using series = clustered_theta_series<T>;
+const std::uint32_t series_engine = 1;
+#elif defined(WORD_TREE_THETA_SERIES)
+template<class T> using series = word_tree_theta_series<T>;
+const std::uint32_t series_engine = 2;
+#else
+template<class T> using series = theta_series<T>;
+const std::uint32_t series_engine = 0;
+#endif
+
+#if defined(FAST_COMPLEX)
+template<class T> using kernel_complex = fast_complex<T>;
+const std::uint32_t complex_engine = 1;
+#else
+template<class T> using kernel_complex = std::complex<T>;
+const std::uint32_t complex_engine = 0;
+#endif
+
+// The engine of this build, the checkpoints of other engines are not resumed.
+const std::uint32_t engine = series_engine | complex_engine << 8;
+
 using namespace std::complex_literals;
 
-int main(int argc, char **argv)
+struct grid
 {
-	const char *args_file_address, *mesh_file_address;
-	if (argc >= 3)
+	real x_min, x_max, y_min, y_max;
+	std::size_t x_count, y_count;
+
+	inline std::size_t size() const
 	{
-		args_file_address = argv[1];
-		mesh_file_address = argv[2];
+		return x_count * y_count;
 	}
-	else
+
+	// The points of the rows [first, last), a row is the set of points with
+	// the same x; rows follow each other in the order of growing x.
+	std::vector<complex> points(const std::size_t first, const std::size_t last) const
+	{
+		const real
+			x_step = (x_max - x_min) / (x_count - 1),
+			y_step = (y_max - y_min) / (y_count - 1);
+
+		std::vector<complex> mesh;
+		mesh.reserve((last - first) * y_count);
+		for (std::size_t i = first; i < last; ++i)
+			for (std::size_t j = 0; j < y_count; ++j)
+				mesh.emplace_back(x_min + i * x_step, y_min + j * y_step);
+		return mesh;
+	}
+
+	// The point k of 'points(0, x_count)', computed in the same way.
+	inline complex point(const std::size_t k) const
+	{
+		const real
+			x_step = (x_max - x_min) / (x_count - 1),
+			y_step = (y_max - y_min) / (y_count - 1);
+		return complex(x_min + k / y_count * x_step, y_min + k % y_count * y_step);
+	}
+
+	// The points of the mesh for 'parallel_map', computed as they are read,
+	// so the threads do not share a stored mesh.
+	struct point_view
+	{
+		const grid *g;
+
+		inline complex operator[](const std::size_t k) const
+		{
+			return g->point(k);
+		}
+	};
+
+	inline point_view view() const
 	{
-		args_file_address = "args.txt";
-		mesh_file_address = "mesh.txt";
+		return { this };
 	}
+};
+
+std::istream &operator>>(std::istream &in, grid &g)
+{
+	return in >> g.x_min >> g.x_max >> g.x_count >> g.y_min >> g.y_max >> g.y_count;
+}
+
+inline bool operator==(const grid &g, const grid &h)
+{
+	return
+		g.x_min == h.x_min && g.x_max == h.x_max && g.x_count == h.x_count &&
+		g.y_min == h.y_min && g.y_max == h.y_max && g.y_count == h.y_count;
+}
 
+// Creates (or truncates) the file and extends it to 'size' bytes.
+bool create_file(const std::string &file, const std::size_t size)
+{
+	std::ofstream fout(file, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!fout.is_open())
+	{
+		std::cerr << "File \'" << file << "\' cannot be created.\n";
+		return false;
+	}
+	if (size > 0)
+	{
+		fout.seekp(size - 1);
+		fout.put(0);
+	}
+	return (bool)fout;
+}
+
+// Everything a worker needs to evaluate its rows of the mesh.
+struct shard_request
+{
 	real tau;
 	triangle<real> tr;
-	complex z_singular;
-
 	transform P, H1, H2;
 	unsigned int level, m;
+	grid mesh;
+	std::size_t first, last;
+	unsigned int threads;
+	std::vector<transform> G;
+};
 
-	std::ifstream fin;
-	
-	fin.open(args_file_address);
-	if (!fin.is_open())
+void write_request(std::ostream &out, const shard_request &r)
+{
+	write_binary(out, r.tau);
+	write_binary(out, r.tr);
+	write_binary(out, r.P);
+	write_binary(out, r.H1);
+	write_binary(out, r.H2);
+	write_binary(out, r.level);
+	write_binary(out, r.m);
+	write_binary(out, r.mesh);
+	write_binary(out, r.first);
+	write_binary(out, r.last);
+	write_binary(out, r.threads);
+	write_sized_vector(out, r.G);
+}
+
+std::istream &read_request(std::istream &in, shard_request &r)
+{
+	read_binary(in, r.tau);
+	read_binary(in, r.tr);
+	read_binary(in, r.P);
+	read_binary(in, r.H1);
+	read_binary(in, r.H2);
+	read_binary(in, r.level);
+	read_binary(in, r.m);
+	read_binary(in, r.mesh);
+	read_binary(in, r.first);
+	read_binary(in, r.last);
+	read_binary(in, r.threads);
+	return read_sized_vector(in, r.G);
+}
+
+// Reads a request from the standard input and writes the values on the
+// rows of the request to the standard output.
+int run_worker()
+{
+	shard_request r;
+	if (!read_request(std::cin, r))
+	{
+		std::cerr << "Worker: incomplete request.\n";
+		return 1;
+	}
+
+	// Series which are not built from a list of members get the level.
+	solution<real, series, kernel_complex> f;
+	if (r.G.empty())
+		f.build(r.tau, r.tr, r.P, r.level, r.m, r.H1, r.H2);
+	else
+		f.build(r.tau, r.tr, r.P, r.G, r.m, r.H1, r.H2);
+	const auto values = f.parallel_map(r.mesh.points(r.first, r.last), r.threads);
+	std::cout.write((const char*)values.data(), sizeof(complex) * values.size());
+	std::cout.flush();
+	return std::cout ? 0 : 1;
+}
+
+// Splits the rows of the mesh into 'shards' blocks, every block is sent to
+// a worker process started by 'launcher' (or by this executable when the
+// launcher is empty) and the values are stored in 'file' by offset. Local
+// workers share the cores of this machine, launched ones use their own.
+bool run_shards(
+	const shard_request &request,
+	const std::size_t shards,
+	const std::string &launcher,
+	const std::string &executable,
+	const std::string &file
+) {
+	const auto &mesh = request.mesh;
+	if (!create_file(file, sizeof(complex) * mesh.size()))
+		return false;
+
+	std::signal(SIGPIPE, SIG_IGN);
+
+	std::vector<char> done(shards, false);
+	const unsigned int cores = std::max(std::thread::hardware_concurrency(), 1U);
+	const auto worker = [&](const std::size_t k)
+	{
+		shard_request r = request;
+		r.first = mesh.x_count * k / shards;
+		r.last = mesh.x_count * (k + 1) / shards;
+		r.threads = launcher.empty()
+			? std::max<unsigned int>(cores * (k + 1) / shards - cores * k / shards, 1)
+			: 0;
+		try
+		{
+			child_process child;
+			if (launcher.empty())
+				child = spawn_process({ executable, "--worker" });
+			else
+			{
+				std::string command = launcher;
+				const std::string key = "{shard}";
+				for (auto pos = command.find(key); pos != std::string::npos; pos = command.find(key))
+					command.replace(pos, key.size(), std::to_string(k));
+				child = spawn_shell(command + " --worker");
+			}
+
+			std::ostringstream sout;
+			write_request(sout, r);
+			const auto message = sout.str();
+			write_all(child.in, message.data(), message.size());
+			close(child.in);
+			child.in = -1;
+
+			std::fstream fout(file, std::ios::in | std::ios::out | std::ios::binary);
+			fout.seekp(sizeof(complex) * r.first * mesh.y_count);
+			const std::size_t expected = sizeof(complex) * (r.last - r.first) * mesh.y_count;
+			std::size_t received = 0;
+			std::vector<char> buffer(1 << 20);
+			for (std::size_t n; (n = read_some(child.out, buffer.data(), buffer.size())) > 0;)
+			{
+				n = std::min(n, expected - received);
+				fout.write(buffer.data(), n);
+				received += n;
+			}
+			fout.close();
+
+			const int status = wait_process(child);
+			done[k] = status == 0 && received == expected && fout;
+			if (!done[k])
+				std::cerr
+					<< "Shard " << k << " failed (exit status " << status << ", "
+					<< received << " of " << expected << " bytes).\n";
+		}
+		catch (const std::exception &e)
+		{
+			std::cerr << "Shard " << k << " failed: " << e.what() << std::endl;
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (std::size_t k = 0; k < shards; ++k)
+		pool.emplace_back(worker, k);
+	for (auto &thr : pool)
+		thr.join();
+
+	for (const auto d : done)
+		if (!d)
+			return false;
+	return true;
+}
+
+struct output_format
+{
+	bool chunked;
+	chunk_mode_t mode;
+	double error_bound;
+};
+
+// Rewrites the raw values in 'file' into the chunked container.
+bool compress_file(const std::string &file, const output_format &format)
+{
+	const std::string temp = file + ".tmp";
+	{
+		std::ifstream fin(file, std::ios::in | std::ios::binary);
+		chunked_ofstream<complex> fout;
+		fout.open(temp, format.mode, format.error_bound);
+		std::vector<complex> block;
+		do
+		{
+			block.resize(1 << 20);
+			fin.read((char*)block.data(), sizeof(complex) * block.size());
+			block.resize(fin.gcount() / sizeof(complex));
+			fout.write_vector(block);
+		}
+		while (fin);
+		fout.close();
+		if (!fin.eof() || !fout)
+		{
+			std::cerr << "File \'" << file << "\' cannot be compressed.\n";
+			std::remove(temp.c_str());
+			return false;
+		}
+	}
+	return std::rename(temp.c_str(), file.c_str()) == 0;
+}
+
+bool load_group(const std::string &file, const problem_key &key, std::vector<transform> &G)
+{
+	std::ifstream fin(file, std::ios::in | std::ios::binary);
+	problem_key k;
+	std::uint32_t e;
+	return read_binary(fin, k) && read_binary(fin, e) && k == key && e == engine && read_sized_vector(fin, G);
+}
+
+void save_group(const std::string &file, const problem_key &key, const std::vector<transform> &G)
+{
+	std::ofstream fout(file, std::ios::out | std::ios::binary | std::ios::trunc);
+	write_binary(fout, key);
+	write_binary(fout, engine);
+	write_sized_vector(fout, G);
+}
+
+// Evaluates the mesh by tiles of 'tile_rows' rows. Every finished tile is
+// written to 'file' by offset and recorded in the index '<file>.ckpt', so a
+// restarted run with the same problem, engine and mesh skips the recorded tiles.
+template<class solution_t>
+bool run_tiles(
+	const solution_t &f,
+	const problem_key &key,
+	const grid &mesh,
+	const std::size_t tile_rows,
+	const std::string &file
+) {
+	const std::string index_file = file + ".ckpt";
+	const std::size_t tiles = (mesh.x_count + tile_rows - 1) / tile_rows;
+	const std::size_t size = sizeof(complex) * mesh.size();
+
+	std::vector<char> done(tiles, false);
+	bool resume = false;
+	{
+		std::ifstream fin(index_file, std::ios::in | std::ios::binary);
+		problem_key k;
+		std::uint32_t e;
+		grid g;
+		std::uint64_t rows;
+		std::error_code error;
+		if (
+			read_binary(fin, k) && read_binary(fin, e) && read_binary(fin, g) && read_binary(fin, rows) &&
+			k == key && e == engine && g == mesh && rows == tile_rows &&
+			std::filesystem::file_size(file, error) == size
+		) {
+			resume = true;
+			for (std::uint64_t i; read_binary(fin, i);)
+				if (i < tiles)
+					done[i] = true;
+		}
+	}
+	if (!resume)
+	{
+		if (!create_file(file, size))
+			return false;
+		std::ofstream index(index_file, std::ios::out | std::ios::binary | std::ios::trunc);
+		write_binary(index, key);
+		write_binary(index, engine);
+		write_binary(index, mesh);
+		write_binary(index, (std::uint64_t)tile_rows);
+	}
+
+	std::fstream fout(file, std::ios::in | std::ios::out | std::ios::binary);
+	std::ofstream index(index_file, std::ios::out | std::ios::binary | std::ios::app);
+
+	std::size_t left = 0;
+	for (const auto d : done)
+		left += !d;
+	if (resume)
+		std::cout
+			<< "Resuming: " << tiles - left << " of " << tiles
+			<< " tiles are already calculated.\n";
+
+	const auto start = std::chrono::steady_clock::now();
+	std::size_t points = 0, finished = 0;
+	for (std::size_t k = 0; k < tiles; ++k)
+	{
+		if (done[k])
+			continue;
+
+		const std::size_t first = k * tile_rows, last = std::min(first + tile_rows, mesh.x_count);
+		const auto values = f.parallel_map(mesh.points(first, last));
+		fout.seekp(sizeof(complex) * first * mesh.y_count);
+		fout.write((const char*)values.data(), sizeof(complex) * values.size());
+		fout.flush();
+		write_binary(index, (std::uint64_t)k);
+		index.flush();
+		if (!fout || !index)
+		{
+			std::cerr << "Tile " << k << " cannot be written.\n";
+			return false;
+		}
+
+		points += values.size();
+		++finished;
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		const double rate = points / elapsed.count();
+		std::cout
+			<< "Tile " << k + 1 << " of " << tiles << ": "
+			<< finished << " of " << left << " tiles, "
+			<< rate << " points/sec, ETA "
+			<< elapsed.count() * (left - finished) / finished << " sec.\n";
+	}
+
+	fout.close();
+	index.close();
+	std::remove(index_file.c_str());
+	return true;
+}
+
+std::vector<std::string> split(const std::string &list)
+{
+	std::vector<std::string> items;
+	std::istringstream in(list);
+	for (std::string item; std::getline(in, item, ',');)
+		if (!item.empty())
+			items.push_back(item);
+	return items;
+}
+
+// Runs every problem of the directory over the meshes and the levels through
+// the reference evaluator ('solution::operator()' with 'theta_series') and
+// through the other engines on 'threads' threads (1 by default), prints the
+// relative errors and the speedups of the engines over the reference (which
+// runs on one thread) and fails if an error exceeds the bound. Reference values
+// smaller than 'floor' times their RMS are compared against that floor,
+// values above 'cutoff' times their median are poles and are skipped.
+int run_compare(std::map<std::string, std::string> &options)
+{
+	const std::string directory = options["compare"].empty() ? "problem_examples" : options["compare"];
+	const auto meshes = split(options["meshes"].empty()
+		? "mesh_examples/11x11.txt,mesh_examples/21x21.txt" : options["meshes"]);
+	const auto levels = split(options["levels"].empty() ? "4,6" : options["levels"]);
+	const double bound = options["bound"].empty() ? 1e-6 : std::stod(options["bound"]);
+	const double floor = options["floor"].empty() ? 1e-6 : std::stod(options["floor"]);
+	const double cutoff = options["cutoff"].empty() ? 1e6 : std::stod(options["cutoff"]);
+	const unsigned int threads = options["threads"].empty() ? 1 : std::max(std::stoul(options["threads"]), 1UL);
+
+	std::vector<std::string> problems;
+	std::error_code error;
+	for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+		if (entry.is_regular_file())
+			problems.push_back(entry.path().string());
+	std::sort(problems.begin(), problems.end());
+	if (problems.empty())
+	{
+		std::cerr << "No problems in \'" << directory << "\'.\n";
+		return 1;
+	}
+
+	using seconds = std::chrono::duration<double>;
+	using clock_t = std::chrono::steady_clock;
+	using engine_t = std::function<std::vector<complex>(
+		const problem_key &, const std::vector<complex> &, double &
+	)>;
+
+	const std::vector<std::pair<std::string, engine_t>> engines = {
+		{ "blocked", [threads](const problem_key &key, const std::vector<complex> &mesh, double &dt)
+		{
+			transform P, H1, H2;
+			problem_transforms(key, P, H1, H2);
+			solution<real> f(key.tau, key.tr, P, key.level, key.m, H1, H2);
+			const auto t = clock_t::now();
+			auto values = f.parallel_map(mesh, threads);
+			dt = seconds(clock_t::now() - t).count();
+			return values;
+		} },
+		{ "member-parallel", [threads](const problem_key &key, const std::vector<complex> &mesh, double &dt)
+		{
+			transform P, H1, H2;
+			problem_transforms(key, P, H1, H2);
+			solution<real> f(key.tau, key.tr, P, key.level, key.m, H1, H2);
+			const auto t = clock_t::now();
+			std::vector<complex> values(mesh.size());
+			for (std::size_t i = 0; i < mesh.size(); ++i)
+				values[i] = f.parallel_evaluate(mesh[i], threads);
+			dt = seconds(clock_t::now() - t).count();
+			return values;
+		} },
+		{ "clustered", [threads](const problem_key &key, const std::vector<complex> &mesh, double &dt)
+		{
+			transform P, H1, H2;
+			problem_transforms(key, P, H1, H2);
+			solution<real, clustered_theta_series> f(key.tau, key.tr, P, key.level, key.m, H1, H2);
+			const auto t = clock_t::now();
+			auto values = f.parallel_map(mesh, threads);
+			dt = seconds(clock_t::now() - t).count();
+			return values;
+		} },
+		{ "word-tree", [threads](const problem_key &key, const std::vector<complex> &mesh, double &dt)
+		{
+			transform P, H1, H2;
+			problem_transforms(key, P, H1, H2);
+			solution<real, word_tree_theta_series> f(key.tau, key.tr, P, key.level, key.m, H1, H2);
+			const auto t = clock_t::now();
+			auto values = f.parallel_map(mesh, threads);
+			dt = seconds(clock_t::now() - t).count();
+			return values;
+		} },
+		{ "fast-complex", [threads](const problem_key &key, const std::vector<complex> &mesh, double &dt)
+		{
+			transform P, H1, H2;
+			problem_transforms(key, P, H1, H2);
+			solution<real, theta_series, fast_complex> f(key.tau, key.tr, P, key.level, key.m, H1, H2);
+			const auto t = clock_t::now();
+			auto values = f.parallel_map(mesh, threads);
+			dt = seconds(clock_t::now() - t).count();
+			return values;
+		} }
+	};
+
+	std::cout.precision(3);
+	bool ok = true;
+	for (const auto &problem : problems)
+	{
+		problem_key key;
+		if (!read_problem(problem, key))
+		{
+			std::cerr << "File \'" << problem << "\' is not a problem.\n";
+			ok = false;
+			continue;
+		}
+		for (const auto &level : levels)
+		{
+			key.level = std::stoul(level);
+			for (const auto &mesh_file : meshes)
+			{
+				grid mesh_grid;
+				std::ifstream fin(mesh_file);
+				if (!(fin >> mesh_grid))
+				{
+					std::cerr << "File \'" << mesh_file << "\' is not a mesh.\n";
+					ok = false;
+					continue;
+				}
+				const auto mesh = mesh_grid.points(0, mesh_grid.x_count);
+
+				transform P, H1, H2;
+				problem_transforms(key, P, H1, H2);
+				solution<real> f(key.tau, key.tr, P, key.level, key.m, H1, H2);
+				auto t = clock_t::now();
+				const auto reference = f.map(mesh);
+				const double reference_time = seconds(clock_t::now() - t).count();
+
+				// Values far above the median are poles, where every engine
+				// returns rounding noise; they are not compared.
+				std::vector<double> magnitudes;
+				for (const auto &r : reference)
+					if (std::isfinite(std::abs(r)))
+						magnitudes.push_back(std::abs(r));
+				std::nth_element(magnitudes.begin(), magnitudes.begin() + magnitudes.size() / 2, magnitudes.end());
+				const double limit = magnitudes.empty() ? 0 : cutoff * magnitudes[magnitudes.size() / 2];
+				std::vector<char> compared(mesh.size());
+				double rms = 0;
+				std::size_t count = 0;
+				for (std::size_t i = 0; i < mesh.size(); ++i)
+					if ((compared[i] = std::abs(reference[i]) <= limit))
+					{
+						rms += std::norm(reference[i]);
+						++count;
+					}
+				rms = std::sqrt(rms / std::max<std::size_t>(count, 1));
+
+				for (const auto &engine : engines)
+				{
+					double dt = 0;
+					const auto values = engine.second(key, mesh, dt);
+					double max_error = 0, rms_error = 0;
+					for (std::size_t i = 0; i < mesh.size(); ++i)
+					{
+						if (!compared[i])
+							continue;
+						const double e = std::abs(values[i] - reference[i])
+							/ std::max(std::abs(reference[i]), floor * rms);
+						max_error = std::isnan(e) ? INFINITY : std::max(max_error, e);
+						rms_error += e * e;
+					}
+					rms_error = std::sqrt(rms_error / std::max<std::size_t>(count, 1));
+
+					const bool passed = max_error <= bound;
+					ok = ok && passed;
+					std::cout
+						<< (passed ? "ok   " : "FAIL ") << problem
+						<< " level " << key.level << ' ' << mesh_file << ' ' << engine.first
+						<< ": max " << max_error << ", rms " << rms_error
+						<< ", speedup " << reference_time / dt;
+					if (threads > 1)
+						std::cout << " (" << reference_time / dt / threads << " per thread)";
+					std::cout << ", poles skipped " << mesh.size() - count << std::endl;
+				}
+			}
+		}
+	}
+
+	return ok ? 0 : 1;
+}
+
+// Parses "<first>:<last>:<count>" (the count of evenly spaced values) or a
+// single value.
+bool parse_range(const std::string &text, std::vector<real> &values)
+{
+	values.clear();
+	const auto items = [&text]()
+	{
+		std::vector<std::string> items;
+		std::istringstream in(text);
+		for (std::string item; std::getline(in, item, ':');)
+			items.push_back(item);
+		return items;
+	}();
+	try
+	{
+		if (items.size() == 1)
+			values.push_back(std::stod(items[0]));
+		else if (items.size() == 3)
+		{
+			const real first = std::stod(items[0]), last = std::stod(items[1]);
+			const std::size_t count = std::stoul(items[2]);
+			for (std::size_t i = 0; i < count; ++i)
+				values.push_back(count == 1 ? first : first + (last - first) * i / (count - 1));
+		}
+	}
+	catch (const std::exception&)
+	{
+		values.clear();
+	}
+	return !values.empty();
+}
+
+// A problem of the sweep as it is stored in the index of the output.
+struct sweep_record
+{
+	real tau, C_x, C_y;
+	std::uint64_t members;
+};
+
+const char SWEEP_MAGIC[8] = { 'S', 'W', 'E', 'E', 'P', '0', '1', 0 };
+
+// Solves the problem of 'args' for every tau of '--tau=<range>' and every
+// vertex C of '--vertex=<x range>,<y range>' or of the angle triples (at A,
+// B and C, in degrees) of the lines of '--angles=<file>', with A, B and the
+// rest of the problem fixed. The threads take tiles of the mesh of the built
+// problems first and build the next problem only when no tile is left and
+// fewer than '--window=<N>' problems are built and unfinished, so the
+// builds overlap the evaluations and the memory is bounded. All values go
+// into one file: the magic, the counts of problems and of points, a record
+// per problem (its 'members' are 0 until it is finished) and the values of
+// the problems one after another, each in the order of the mesh.
+int run_sweep(
+	std::map<std::string, std::string> &options,
+	const std::string &args_file_address,
+	const std::string &mesh_file_address
+) {
+	problem_key base;
+	if (!read_problem(args_file_address, base))
+	{
+		std::cerr << "File \'" << args_file_address << "\' not found.\n";
+		return 1;
+	}
+	grid mesh_grid;
+	{
+		std::ifstream fin(mesh_file_address);
+		if (!(fin >> mesh_grid))
+		{
+			std::cerr << "File \'" << mesh_file_address << "\' not found.\n";
+			return 1;
+		}
+	}
+
+	std::vector<real> taus;
+	if (!parse_range(options["tau"].empty() ? std::to_string(base.tau) : options["tau"], taus))
+	{
+		std::cerr << "Bad tau range \'" << options["tau"] << "\'.\n";
+		return 1;
+	}
+
+	std::vector<std::complex<real>> vertices;
+	if (options.count("angles"))
+	{
+		std::ifstream fin(options["angles"]);
+		if (!fin.is_open())
+		{
+			std::cerr << "File \'" << options["angles"] << "\' not found.\n";
+			return 1;
+		}
+		const auto AB = base.tr.B - base.tr.A;
+		for (real alpha, beta, gamma; fin >> alpha >> beta >> gamma;)
+		{
+			if (std::abs(alpha + beta + gamma - 180) > 1e-9 * 180)
+			{
+				std::cerr << "The angles " << alpha << ' ' << beta << ' ' << gamma << " are not of a triangle.\n";
+				return 1;
+			}
+			alpha *= PI / 180; beta *= PI / 180;
+			vertices.push_back(base.tr.A + AB * std::polar(std::sin(beta) / std::sin(alpha + beta), alpha));
+		}
+	}
+	else if (options.count("vertex"))
+	{
+		const auto ranges = split(options["vertex"]);
+		std::vector<real> xs, ys;
+		if (ranges.size() != 2 || !parse_range(ranges[0], xs) || !parse_range(ranges[1], ys))
+		{
+			std::cerr << "Bad vertex ranges \'" << options["vertex"] << "\'.\n";
+			return 1;
+		}
+		for (const auto x : xs)
+			for (const auto y : ys)
+				vertices.emplace_back(x, y);
+	}
+	else
+		vertices.push_back(base.tr.C);
+
+	std::vector<problem_key> problems;
+	for (const auto tau : taus)
+		for (const auto C : vertices)
+		{
+			problems.push_back(base);
+			problems.back().tau = tau;
+			problems.back().tr.C = C;
+		}
+
+	const std::size_t count = problems.size(), points = mesh_grid.size();
+	const std::size_t header = sizeof(SWEEP_MAGIC) + 2 * sizeof(std::uint64_t);
+	const std::size_t values_offset = header + count * sizeof(sweep_record);
+	const std::string file =
+		"sweep[" + args_file_address + "][" + mesh_file_address + "].dat";
+	mapped_file output;
+	if (!output.create(file, values_offset + count * points * sizeof(complex)))
+	{
+		std::cerr << "File \'" << file << "\' cannot be created.\n";
+		return 1;
+	}
+	char *const data = output.data<char>();
+	std::memcpy(data, SWEEP_MAGIC, sizeof(SWEEP_MAGIC));
+	const std::uint64_t counts[2] = { count, points };
+	std::memcpy(data + sizeof(SWEEP_MAGIC), counts, sizeof(counts));
+	sweep_record *const records = (sweep_record*)(data + header);
+	for (std::size_t k = 0; k < count; ++k)
+		records[k] = { problems[k].tau, problems[k].tr.C.real(), problems[k].tr.C.imag(), 0 };
+	complex *const values = (complex*)(data + values_offset);
+
+	const auto mesh = mesh_grid.points(0, mesh_grid.x_count);
+
+	const unsigned int threads = options["threads"].empty()
+		? std::max(std::thread::hardware_concurrency(), 1U)
+		: std::max(std::stoul(options["threads"]), 1UL);
+	const std::size_t window = options["window"].empty()
+		? threads
+		: std::max<std::size_t>(std::stoul(options["window"]), 1);
+	const std::size_t tile = 4096, tiles = (points + tile - 1) / tile;
+
+	using solution_t = solution<real, series, kernel_complex>;
+	struct job_t
+	{
+		std::size_t index;
+		std::unique_ptr<solution_t> f;
+		std::size_t next, done;
+	};
+	std::list<job_t> live;
+	std::size_t built = 0, finished = 0, failed = 0;
+	double build_time = 0, evaluation_time = 0;
+	std::mutex mutex;
+	std::condition_variable changed;
+
+	using seconds = std::chrono::duration<double>;
+	using clock_t = std::chrono::steady_clock;
+	const auto start = clock_t::now();
+
+	const auto finish = [&](const std::list<job_t>::iterator job)
+	{
+		records[job->index].members = job->f->members_count();
+		live.erase(job);
+		if (++finished % std::max<std::size_t>(count / 100, 1) == 0 || finished == count)
+			std::cout
+				<< finished << " of " << count << " problems, "
+				<< seconds(clock_t::now() - start).count() << " sec.\n";
+	};
+
+	const auto worker = [&]()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;)
+		{
+			// The oldest built problem with a tile left.
+			auto job = std::find_if(live.begin(), live.end(),
+				[tiles](const job_t &j) { return j.f && j.next < tiles; });
+			if (job != live.end())
+			{
+				const std::size_t k = job->next++, first = k * tile, len = std::min(tile, points - first);
+				const solution_t &f = *job->f;
+				complex *const out = values + job->index * points + first;
+				lock.unlock();
+				const auto t = clock_t::now();
+				f.parallel_map(mesh.begin() + first, len, out, 1);
+				const double dt = seconds(clock_t::now() - t).count();
+				lock.lock();
+				evaluation_time += dt;
+				if (++job->done == tiles)
+				{
+					finish(job);
+					changed.notify_all();
+				}
+				continue;
+			}
+			if (built < count && live.size() < window)
+			{
+				const std::size_t index = built++;
+				live.push_back({ index, nullptr, 0, 0 });
+				const auto slot = std::prev(live.end());
+				lock.unlock();
+				const auto t = clock_t::now();
+				std::unique_ptr<solution_t> f;
+				try
+				{
+					problem_transform P, H1, H2;
+					problem_transforms(problems[index], P, H1, H2);
+					f = std::make_unique<solution_t>();
+					f->build(
+						problems[index].tau, problems[index].tr, P,
+						problems[index].level, problems[index].m, H1, H2
+					);
+				}
+				catch (const std::exception&)
+				{
+					f.reset();
+				}
+				const double dt = seconds(clock_t::now() - t).count();
+				lock.lock();
+				build_time += dt;
+				if (f)
+				{
+					slot->f = std::move(f);
+					if (tiles == 0)
+						finish(slot);
+				}
+				else
+				{
+					++failed;
+					live.erase(slot);
+					++finished;
+				}
+				changed.notify_all();
+				continue;
+			}
+			if (built == count && live.empty())
+				break;
+			changed.wait(lock);
+		}
+		changed.notify_all();
+	};
+
+	std::vector<std::thread> pool;
+	for (unsigned int i = 1; i < threads; ++i)
+		pool.emplace_back(worker);
+	worker();
+	for (auto &thr : pool)
+		thr.join();
+
+	const double elapsed = seconds(clock_t::now() - start).count();
+	std::cout
+		<< "The values of " << count - failed << " problems on " << points
+		<< " points are written to \'" << file << "\' in " << elapsed << " sec ("
+		<< build_time << " sec of builds, " << evaluation_time << " sec of evaluation by "
+		<< threads << " threads).\n";
+	if (failed)
+		std::cerr << failed << " problems are not built, their records have no members.\n";
+	return failed ? 1 : 0;
+}
+
+// Solves the problem as a graph of tasks: the group is built while the
+// points of the mesh are generated and written and the values file is
+// created, the tiles of 'tile_rows' rows are evaluated in parallel as soon
+// as the group and the points are ready, and every finished tile is written
+// (in the order of the tiles) while the later ones are evaluated. Prints the
+// times of the stages and the critical path of the run. An evaluation task
+// runs on its thread of the graph, so it neither pins that thread nor copies
+// the members.
+int run_pipeline(
+	const problem_key &key,
+	const grid &mesh_grid,
+	const std::string &mesh_file_address,
+	const std::string &values_file_address,
+	std::size_t tile_rows,
+	unsigned int threads
+) {
+	if (threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 1U);
+	if (tile_rows == 0)
+		tile_rows = std::max<std::size_t>(mesh_grid.x_count / (4 * threads), 1);
+	const std::size_t tiles = (mesh_grid.x_count + tile_rows - 1) / tile_rows;
+
+	solution<real, series, kernel_complex> f;
+	std::vector<complex> mesh, values;
+	std::ofstream fout;
+
+	task_graph graph;
+	const auto build = graph.add("build", [&]()
+	{
+		transform P, H1, H2;
+		problem_transforms(key, P, H1, H2);
+		f.build(key.tau, key.tr, P, key.level, key.m, H1, H2);
+	});
+	const auto points = graph.add("mesh", [&]()
+	{
+		mesh = mesh_grid.points(0, mesh_grid.x_count);
+		values.resize(mesh.size());
+	});
+	graph.add("mesh file", [&]()
+	{
+		typed_ofstream<complex> mout;
+		mout.open(
+			"mesh[" + mesh_file_address + "].dat",
+			std::ios::out | std::ios::binary | std::ios::trunc
+		);
+		mout.write_vector(mesh);
+		mout.close();
+	}, { points });
+	const auto output = graph.add("output", [&]()
+	{
+		fout.open(values_file_address, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!fout.is_open())
+			throw std::runtime_error("File \'" + values_file_address + "\' cannot be created.");
+	});
+	std::size_t written = output;
+	for (std::size_t k = 0; k < tiles; ++k)
+	{
+		const std::size_t
+			first = k * tile_rows * mesh_grid.y_count,
+			last = std::min((k + 1) * tile_rows, mesh_grid.x_count) * mesh_grid.y_count;
+		const auto evaluated = graph.add("evaluate", [&, first, last]()
+		{
+			f.parallel_map(mesh.begin() + first, last - first, values.begin() + first, 1);
+		}, { build, points });
+		written = graph.add("write", [&, first, last]()
+		{
+			if (!fout.write((const char*)(values.data() + first), sizeof(complex) * (last - first)))
+				throw std::runtime_error("File \'" + values_file_address + "\' cannot be written.");
+		}, { evaluated, written });
+	}
+	graph.add("close", [&]()
+	{
+		fout.close();
+		if (!fout)
+			throw std::runtime_error("File \'" + values_file_address + "\' cannot be written.");
+	}, { written });
+
+	try
+	{
+		graph.run(threads);
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << e.what() << '\n';
+		return 1;
+	}
+
+	// The stages with the span of their tasks and the time spent in them.
+	std::vector<std::string> stages;
+	std::map<std::string, std::array<double, 3>> spans;
+	for (std::size_t i = 0; i < graph.size(); ++i)
+	{
+		const auto &task = graph[i];
+		if (!spans.count(task.stage))
+		{
+			stages.push_back(task.stage);
+			spans[task.stage] = { task.start, task.finish, 0 };
+		}
+		auto &span = spans[task.stage];
+		span[0] = std::min(span[0], task.start);
+		span[1] = std::max(span[1], task.finish);
+		span[2] += task.finish - task.start;
+	}
+	std::cout
+		<< "Approximate solution with " << f.members_count() << " members of the series, "
+		<< mesh.size() << " points in " << tiles << " tiles by " << threads << " threads.\n";
+	for (const auto &stage : stages)
+	{
+		const auto &span = spans[stage];
+		std::cout
+			<< "  " << stage << ": " << span[0] * 1000 << " - " << span[1] * 1000
+			<< " ms, busy " << span[2] * 1000 << " ms\n";
+	}
+
+	// The tasks of the path are reported by stages, in the order of the
+	// first task of a stage on the path.
+	const auto path = graph.critical_path();
+	std::vector<std::string> path_stages;
+	std::map<std::string, std::pair<std::size_t, double>> on_path;
+	for (const auto i : path)
+	{
+		const auto &task = graph[i];
+		if (!on_path.count(task.stage))
+			path_stages.push_back(task.stage);
+		auto &s = on_path[task.stage];
+		++s.first;
+		s.second += task.finish - task.start;
+	}
+	double busy = 0;
+	std::cout << "Critical path:";
+	for (const auto &stage : path_stages)
+	{
+		const auto &s = on_path[stage];
+		busy += s.second;
+		std::cout << (stage == path_stages.front() ? " " : ", ") << stage;
+		if (s.first > 1)
+			std::cout << " x" << s.first;
+		std::cout << " " << s.second * 1000 << " ms";
+	}
+	std::cout
+		<< "; " << busy * 1000 << " ms of work on the path of "
+		<< graph[path.back()].finish * 1000 << " ms.\n";
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<std::string> files;
+	std::map<std::string, std::string> options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (arg.compare(0, 2, "--") == 0)
+		{
+			const auto pos = arg.find('=');
+			options[arg.substr(2, pos - 2)] = pos == std::string::npos ? "" : arg.substr(pos + 1);
+		}
+		else
+			files.push_back(arg);
+	}
+
+	if (options.count("worker"))
+		return run_worker();
+
+	const std::string
+		args_file_address = files.size() >= 1 ? files[0] : "args.txt",
+		mesh_file_address = files.size() >= 2 ? files[1] : "mesh.txt";
+
+	if (options.count("compare"))
+		return run_compare(options);
+
+	if (options.count("sweep"))
+		return run_sweep(options, args_file_address, mesh_file_address);
+
+	problem_key key;
+	if (!read_problem(args_file_address, key))
 	{
 		std::cerr << "File \'" << args_file_address << "\' not found.\n";
 		return 0;
 	}
-	fin >> tau >> tr >> z_singular >> level >> m;
-	fin.close();
+	const real tau = key.tau;
+	const triangle<real> tr = key.tr;
+	const unsigned int level = key.level, m = key.m;
 
-	P = transform(2. + 7.i, 9., 6.i, 11.);
-	H1 = transform(0., 1., 1., -inverse(P)((z_singular - tr.A) / (tr.B - tr.A)));
-	H2 = transform();
+	transform P, H1, H2;
+	problem_transforms(key, P, H1, H2);
+
+	std::ifstream fin;
 
 	/*std::cout
 		<< "tau = " << tau << std::endl
@@ -58,8 +1098,87 @@ int main(int argc, char **argv)
 		<< "H1 = " << H1 << std::endl
 		<< "H2 = " << H2 << std::endl;//*/
 
+	const std::string values_file_address =
+		"values[" + args_file_address + "][" + mesh_file_address + "].dat";
+	const std::string group_file_address = values_file_address + ".group";
+
+	output_format format = { options["format"] == "chunked", LOSSLESS, 0 };
+	if (options["lossy"] == "float32")
+		format.mode = FLOAT32;
+	else if (!options["error-bound"].empty())
+	{
+		format.mode = QUANTIZED;
+		format.error_bound = std::stod(options["error-bound"]);
+		if (!(format.error_bound > 0))
+		{
+			std::cerr << "The error bound must be positive.\n";
+			return 1;
+		}
+	}
+	if (format.mode != LOSSLESS && !format.chunked)
+		std::cerr << "Lossy modes need \'--format=chunked\', the values are written raw.\n";
+
+	if (options.count("extrapolate"))
+		for (const auto option : { "shards", "checkpoint", "query", "points" })
+			if (options.count(option))
+			{
+				std::cerr << "\'--extrapolate\' cannot be used with \'--" << option << "\'.\n";
+				return 1;
+			}
+
+	for (const auto output : { "vtk", "pyramid" })
+		if (options.count(output))
+			for (const auto option : { "shards", "checkpoint", "query", "points" })
+				if (options.count(option))
+				{
+					std::cerr << "\'--" << output << "\' cannot be used with \'--" << option << "\'.\n";
+					return 1;
+				}
+
+	if (options.count("pipeline"))
+	{
+		for (const auto option : { "shards", "checkpoint", "query", "points", "extrapolate", "vtk", "pyramid" })
+			if (options.count(option))
+			{
+				std::cerr << "\'--pipeline\' cannot be used with \'--" << option << "\'.\n";
+				return 1;
+			}
+		if (format.chunked)
+		{
+			std::cerr << "\'--pipeline\' writes the values raw.\n";
+			return 1;
+		}
+		grid mesh_grid;
+		fin.open(mesh_file_address);
+		if (!(fin >> mesh_grid))
+		{
+			std::cerr << "File \'" << mesh_file_address << "\' not found.\n";
+			return 1;
+		}
+		fin.close();
+		return run_pipeline(
+			key, mesh_grid, mesh_file_address, values_file_address,
+			options["tile-rows"].empty() ? 0 : std::max(std::stoul(options["tile-rows"]), 1UL),
+			options["threads"].empty() ? 0 : std::stoul(options["threads"])
+		);
+	}
+
+	const bool checkpoint = options.count("checkpoint");
+	std::vector<transform> G;
+
 	auto t = clock();
-	solution<real> f(tau, tr, P, level, m, H1, H2);
+	solution<real, series, kernel_complex> f;
+	if (checkpoint && load_group(group_file_address, key, G) && !G.empty())
+	{
+		f.build(tau, tr, P, G, m, H1, H2);
+		std::cout << "The group is loaded from \'" << group_file_address << "\'.\n";
+	}
+	else
+	{
+		f.build(tau, tr, P, level, m, H1, H2);
+		if (checkpoint)
+			save_group(group_file_address, key, f.group());
+	}
 	auto dt = (double)(clock() - t) / CLOCKS_PER_SEC;
 	std::cout
 		<< "Approximate solution with " << f.members_count()
@@ -68,16 +1187,65 @@ int main(int argc, char **argv)
 		std::cout << dt * 1000 << " ms.\n";
 	else
 		std::cout << dt << " sec.\n";
+	std::cout << "Memory placement: " << placement_policy() << ".\n";
 
-	/*complex z;
-	std::cin >> z;
-	std::cout
-		<< "z := " << z << std::endl
-		<< "f(z) -> " << f(z) << std::endl;//*/
+	// The stored group is needed only until the values of the run are written.
+	const auto finish = [&]()
+	{
+		if (checkpoint)
+			std::remove(group_file_address.c_str());
+		return 0;
+	};
 
-	real x_min, x_max, y_min, y_max;
+	if (options.count("query"))
+	{
+		const unsigned int threads = options["threads"].empty() ? 0 : std::stoul(options["threads"]);
+		std::cout.precision(17);
+		for (complex z; std::cin >> z;)
+			std::cout
+				<< "z := " << z << std::endl
+				<< "f(z) -> " << f.parallel_evaluate(z, threads) << std::endl;
+		return finish();
+	}
 
-	std::size_t x_count, y_count;
+	if (options.count("points"))
+	{
+		const std::string points_file_address = options["points"];
+		mapped_file input, output;
+		if (!input.open(points_file_address))
+		{
+			std::cerr << "File \'" << points_file_address << "\' not found.\n";
+			return 1;
+		}
+		if (input.size() % sizeof(complex) != 0)
+		{
+			std::cerr
+				<< "File \'" << points_file_address << "\' is not an array of "
+				<< sizeof(complex) << "-byte points.\n";
+			return 1;
+		}
+		const std::size_t count = input.size() / sizeof(complex);
+		const std::string file =
+			"values[" + args_file_address + "][" + points_file_address + "].dat";
+		if (!output.create(file, input.size()))
+		{
+			std::cerr << "File \'" << file << "\' cannot be created.\n";
+			return 1;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		f.parallel_map(input.data<const complex>(), count, output.data<complex>());
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		std::cout
+			<< "The values are calculated on " << count
+			<< " points in " << elapsed.count() << " sec.\n";
+		output.close();
+		if (format.chunked && !compress_file(file, format))
+			return 1;
+		return finish();
+	}
+
+	grid mesh_grid;
 
 	fin.open(mesh_file_address);
 	if (!fin.is_open())
@@ -85,33 +1253,121 @@ int main(int argc, char **argv)
 		std::cerr << "File \'" << mesh_file_address << "\' not found.\n";
 		return 0;
 	}
-	fin >> x_min >> x_max >> x_count >> y_min >> y_max >> y_count;
+	fin >> mesh_grid;
 	fin.close();
 
 	/*std::cout
-		<< "x_min = " << x_min << ", x_max = " << x_max
-		<< ", x_count = " << x_count << std::endl
-		<< "y_min = " << y_min << ", y_max = " << y_max
-		<< ", y_count = " << y_count << std::endl;//*/
-
-	const real
-		x_step = (x_max - x_min) / (x_count - 1),
-		y_step = (y_max - y_min) / (y_count - 1);
-
-	std::vector<real> xx(x_count), yy(y_count);
-	for (std::size_t i = 0; i < x_count; ++i)
-		xx.at(i) = x_min + i * x_step;
-	for (std::size_t i = 0; i < y_count; ++i)
-		yy.at(i) = y_min + i * y_step;
-
-	std::vector<complex> mesh;
-	mesh.reserve(x_count * y_count);
-	for (const auto x : xx)
-		for (const auto y : yy)
-			mesh.emplace_back(x, y);
-	
+		<< "x_min = " << mesh_grid.x_min << ", x_max = " << mesh_grid.x_max
+		<< ", x_count = " << mesh_grid.x_count << std::endl
+		<< "y_min = " << mesh_grid.y_min << ", y_max = " << mesh_grid.y_max
+		<< ", y_count = " << mesh_grid.y_count << std::endl;//*/
+
+	typed_ofstream<complex> fout;
+	fout.open(
+		"mesh[" + mesh_file_address + "].dat",
+		std::ios::out | std::ios::binary | std::ios::trunc
+	);
+	for (std::size_t i = 0; i < mesh_grid.x_count; ++i)
+		fout.write_vector(mesh_grid.points(i, i + 1));
+	fout.close();
+
+	if (options.count("shards"))
+	{
+		std::size_t shards = 0;
+		if (options["shards"].find_first_not_of("0123456789") == std::string::npos)
+		{
+			try
+			{
+				shards = std::stoul(options["shards"]);
+			}
+			catch (const std::exception&)
+			{
+			}
+		}
+		if (shards == 0)
+		{
+			std::cerr << "The number of shards must be a positive integer.\n";
+			return 1;
+		}
+
+		shard_request request;
+		request.tau = tau;
+		request.tr = tr;
+		request.P = P;
+		request.H1 = H1;
+		request.H2 = H2;
+		request.level = level;
+		request.m = m;
+		request.mesh = mesh_grid;
+		request.first = 0;
+		request.last = mesh_grid.x_count;
+		request.threads = 0;
+		request.G = f.group();
+
+		const auto start = std::chrono::steady_clock::now();
+		const bool ok = run_shards(
+			request, shards, options["launcher"], self_executable(argv[0]), values_file_address
+		);
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if (!ok)
+		{
+			std::cerr << "The values are not calculated.\n";
+			return 1;
+		}
+		std::cout
+			<< "The values are calculated on " << mesh_grid.size()
+			<< " points by " << shards << " workers in " << elapsed.count() << " sec.\n";
+		if (format.chunked && !compress_file(values_file_address, format))
+			return 1;
+		return finish();
+	}
+
+	if (checkpoint)
+	{
+		const std::size_t tile_rows = options["tile-rows"].empty()
+			? std::max<std::size_t>((1 << 20) / std::max<std::size_t>(mesh_grid.y_count, 1), 1)
+			: std::max(std::stoul(options["tile-rows"]), 1UL);
+
+		const auto start = std::chrono::steady_clock::now();
+		if (!run_tiles(f, key, mesh_grid, tile_rows, values_file_address))
+		{
+			std::cerr << "The values are not calculated.\n";
+			return 1;
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		std::cout
+			<< "The values are calculated on " << mesh_grid.size()
+			<< " points in " << elapsed.count() << " sec.\n";
+		if (format.chunked && !compress_file(values_file_address, format))
+			return 1;
+		return finish();
+	}
+
+	// The values are written first by the threads which compute them, so
+	// their pages are placed on the nodes of those threads.
 	t = clock();
-	std::vector<complex> values = f.parallel_map(mesh);
+	uninitialized_vector<complex> values;
+	if (options.count("extrapolate"))
+	{
+		const std::vector<complex> mesh = mesh_grid.points(0, mesh_grid.x_count);
+		const std::string method = options["extrapolate"];
+		if (!method.empty() && method != "levin" && method != "wynn")
+		{
+			std::cerr << "Unknown extrapolation \'" << method << "\', use \'levin\' or \'wynn\'.\n";
+			return 1;
+		}
+		std::vector<real> errors;
+		f.parallel_extrapolate(mesh, values, errors, method == "wynn" ? WYNN : LEVIN);
+		typed_ofstream<real> efout;
+		efout.open(values_file_address + ".err", std::ios::out | std::ios::binary | std::ios::trunc);
+		efout.write_vector(errors);
+		efout.close();
+	}
+	else
+	{
+		values.resize(mesh_grid.size());
+		f.parallel_map(mesh_grid.view(), values.size(), values.begin());
+	}
 	dt = (double)(clock() - t) / CLOCKS_PER_SEC;
 	std::cout
 		<< "The values are calculated on "
@@ -120,20 +1376,42 @@ int main(int argc, char **argv)
 		std::cout << dt * 1000 << " ms.\n";
 	else
 		std::cout << dt << " sec.\n";
-	
-	typed_ofstream<complex> fout;
-	fout.open(
-		std::string("mesh[") + mesh_file_address + "].dat",
-		std::ios::out | std::ios::binary | std::ios::trunc
-	);
-	fout.write_vector(mesh);
-	fout.close();
+
+	if (options.count("vtk"))
+	{
+		const std::string file = values_file_address.substr(0, values_file_address.size() - 4) + ".vtk";
+		if (!write_vtk(
+			file,
+			mesh_grid.x_min, (mesh_grid.x_max - mesh_grid.x_min) / (mesh_grid.x_count - 1), mesh_grid.x_count,
+			mesh_grid.y_min, (mesh_grid.y_max - mesh_grid.y_min) / (mesh_grid.y_count - 1), mesh_grid.y_count,
+			values
+		))
+			std::cerr << "File \'" << file << "\' cannot be written.\n";
+	}
+
+	if (options.count("pyramid"))
+	{
+		const std::string directory = values_file_address.substr(0, values_file_address.size() - 4) + ".tiles";
+		const std::size_t tile = options["pyramid"].empty() ? 256 : std::max(std::stoul(options["pyramid"]), 1UL);
+		if (!write_pyramid(directory, mesh_grid.x_count, mesh_grid.y_count, values, tile))
+			std::cerr << "Directory \'" << directory << "\' cannot be written.\n";
+	}
+
+	if (format.chunked)
+	{
+		chunked_ofstream<complex> cfout;
+		cfout.open(values_file_address, format.mode, format.error_bound);
+		cfout.write_vector(values);
+		cfout.close();
+		return finish();
+	}
+
 	fout.open(
-		std::string("values[") + args_file_address + "][" + mesh_file_address + "].dat",
+		values_file_address,
 		std::ios::out | std::ios::binary | std::ios::trunc
 	);
 	fout.write_vector(values);
 	fout.close();//*/
 
-	return 0;
+	return finish();
 }
\ No newline at end of file
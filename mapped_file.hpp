@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// A file mapped into memory: 'open' maps an existing file for reading,
+// 'create' makes a file of the given size and maps it for writing.
+class mapped_file
+{
+private:
+	void *address;
+	std::size_t length;
+	int fd;
+
+	bool __map__(const int prot, const int advice)
+	{
+		if (length == 0)
+			return true;
+		address = mmap(nullptr, length, prot, MAP_SHARED, fd, 0);
+		if (address == MAP_FAILED)
+		{
+			address = nullptr;
+			close();
+			return false;
+		}
+		madvise(address, length, advice);
+		return true;
+	}
+
+public:
+	mapped_file() : address(nullptr), length(0), fd(-1) {}
+
+	mapped_file(const mapped_file &) = delete;
+	mapped_file &operator=(const mapped_file &) = delete;
+
+	~mapped_file()
+	{
+		close();
+	}
+
+	bool open(const std::string &file)
+	{
+		close();
+		fd = ::open(file.c_str(), O_RDONLY);
+		struct stat st;
+		if (fd < 0 || fstat(fd, &st) != 0)
+		{
+			close();
+			return false;
+		}
+		length = st.st_size;
+		return __map__(PROT_READ, MADV_SEQUENTIAL);
+	}
+
+	bool create(const std::string &file, const std::size_t size)
+	{
+		close();
+		fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0 || ftruncate(fd, size) != 0)
+		{
+			close();
+			return false;
+		}
+		length = size;
+		return __map__(PROT_READ | PROT_WRITE, MADV_SEQUENTIAL);
+	}
+
+	void close()
+	{
+		if (address != nullptr)
+			munmap(address, length);
+		if (fd >= 0)
+			::close(fd);
+		address = nullptr;
+		length = 0;
+		fd = -1;
+	}
+
+	template<class T>
+	inline T *data() const
+	{
+		return (T*)address;
+	}
+
+	inline std::size_t size() const
+	{
+		return length;
+	}
+};
\ No newline at end of file
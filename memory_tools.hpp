@@ -0,0 +1,294 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <new>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#ifdef __linux__
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+const std::size_t HUGE_PAGE_SIZE = 2 << 20;
+
+// Allocates blocks of at least a huge page with 'mmap' and asks the kernel to
+// back them with transparent huge pages; smaller blocks come from 'new'.
+// An 'mmap' block is aligned to a huge page (a huge page more is mapped and
+// the ends are unmapped), since the kernel need not align it. Its pages are
+// placed on the NUMA node of the thread which touches them first.
+template<class T>
+struct huge_page_allocator
+{
+	using value_type = T;
+
+	huge_page_allocator() noexcept {}
+
+	template<class U>
+	huge_page_allocator(const huge_page_allocator<U>&) noexcept {}
+
+	static inline std::size_t __mapped_size__(const std::size_t n)
+	{
+		const std::size_t size = n * sizeof(T);
+		return size < HUGE_PAGE_SIZE ? 0 : (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+	}
+
+	T *allocate(const std::size_t n)
+	{
+#ifdef __linux__
+		if (const auto size = __mapped_size__(n))
+		{
+			void *block = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (block == MAP_FAILED)
+				throw std::bad_alloc();
+			char *const first = static_cast<char*>(block);
+			char *const p = first + (HUGE_PAGE_SIZE - (std::uintptr_t)first % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+			if (p > first)
+				munmap(first, p - first);
+			munmap(p + size, first + HUGE_PAGE_SIZE - p);
+			madvise(p, size, MADV_HUGEPAGE);
+			return reinterpret_cast<T*>(p);
+		}
+#endif
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(T *p, const std::size_t n) noexcept
+	{
+#ifdef __linux__
+		if (const auto size = __mapped_size__(n))
+		{
+			munmap(p, size);
+			return;
+		}
+#endif
+		::operator delete(p);
+	}
+};
+
+template<class T, class U>
+inline bool operator==(const huge_page_allocator<T>&, const huge_page_allocator<U>&) { return true; }
+
+template<class T, class U>
+inline bool operator!=(const huge_page_allocator<T>&, const huge_page_allocator<U>&) { return false; }
+
+template<class T>
+using huge_page_vector = std::vector<T, huge_page_allocator<T>>;
+
+// The same blocks, but the elements made without arguments (by 'resize' or
+// the size constructor) are left uninitialised, so the pages are neither
+// zeroed by the caller nor placed on its node: the threads which write the
+// elements first place them.
+template<class T>
+struct uninitialized_allocator : huge_page_allocator<T>
+{
+	uninitialized_allocator() noexcept {}
+
+	template<class U>
+	uninitialized_allocator(const uninitialized_allocator<U>&) noexcept {}
+
+	template<class U>
+	void construct(U *) noexcept
+	{
+		static_assert(std::is_trivially_copyable<U>::value, "The elements must be trivially copyable.");
+	}
+
+	template<class U, class... Args>
+	void construct(U *p, Args&&... args)
+	{
+		::new((void*)p) U(std::forward<Args>(args)...);
+	}
+};
+
+template<class T>
+using uninitialized_vector = std::vector<T, uninitialized_allocator<T>>;
+
+// The size of the L2 cache of a core, 1 MB where it is not known.
+inline std::size_t l2_cache_size()
+{
+#ifdef __linux__
+	const long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+	if (size > 0)
+		return size;
+#endif
+	return 1 << 20;
+}
+
+// Parses a kernel CPU list such as "0-3,8,10-11".
+inline std::vector<unsigned int> parse_cpu_list(const std::string &list)
+{
+	std::vector<unsigned int> cpus;
+	std::istringstream in(list);
+	for (std::string range; std::getline(in, range, ',');)
+	{
+		unsigned int first, last;
+		const auto dash = range.find('-');
+		try
+		{
+			first = std::stoul(range.substr(0, dash));
+			last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+		}
+		catch (const std::exception&)
+		{
+			continue;
+		}
+		for (auto cpu = first; cpu <= last; ++cpu)
+			cpus.push_back(cpu);
+	}
+	return cpus;
+}
+
+// The NUMA nodes with the CPUs this process may run on. Without the sysfs
+// node directory (or outside Linux) there is one node with all the CPUs.
+struct numa_topology
+{
+	std::vector<std::vector<unsigned int>> nodes;
+
+	numa_topology()
+	{
+		std::vector<unsigned int> allowed;
+#ifdef __linux__
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		if (sched_getaffinity(0, sizeof(set), &set) == 0)
+			for (unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+				if (CPU_ISSET(cpu, &set))
+					allowed.push_back(cpu);
+
+		std::error_code error;
+		std::vector<std::pair<unsigned int, std::vector<unsigned int>>> found;
+		for (const auto &entry : std::filesystem::directory_iterator("/sys/devices/system/node", error))
+		{
+			const auto name = entry.path().filename().string();
+			if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+				!std::all_of(name.begin() + 4, name.end(), [](const char c) { return std::isdigit((unsigned char)c); }))
+				continue;
+			std::ifstream fin(entry.path() / "cpulist");
+			std::string list;
+			std::getline(fin, list);
+			std::vector<unsigned int> cpus;
+			for (const auto cpu : parse_cpu_list(list))
+				if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end())
+					cpus.push_back(cpu);
+			if (!cpus.empty())
+				found.emplace_back(std::stoul(name.substr(4)), std::move(cpus));
+		}
+		std::sort(found.begin(), found.end());
+		for (auto &node : found)
+			nodes.push_back(std::move(node.second));
+#endif
+		if (nodes.empty())
+		{
+			if (allowed.empty())
+				for (unsigned int cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1U); ++cpu)
+					allowed.push_back(cpu);
+			nodes.push_back(allowed);
+		}
+	}
+
+	inline std::size_t cpus_count() const
+	{
+		std::size_t count = 0;
+		for (const auto &node : nodes)
+			count += node.size();
+		return count;
+	}
+
+	// The node and the CPU of the thread 'i' of 'threads': the threads are
+	// spread over the nodes in proportion to their CPUs, consecutive threads
+	// share a node.
+	inline std::pair<std::size_t, unsigned int> place(const std::size_t i, const std::size_t threads) const
+	{
+		const std::size_t cpus = cpus_count();
+		std::size_t k = i * cpus / std::max<std::size_t>(threads, 1);
+		for (std::size_t node = 0; node < nodes.size(); ++node)
+		{
+			if (k < nodes[node].size())
+				return { node, nodes[node][k] };
+			k -= nodes[node].size();
+		}
+		return { nodes.size() - 1, nodes.back().back() };
+	}
+
+	static const numa_topology &get()
+	{
+		static const numa_topology topology;
+		return topology;
+	}
+};
+
+inline bool pin_thread(const unsigned int cpu)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
+
+// Saves the CPU affinity of the calling thread and restores it at the end of
+// the scope, so work which pins the thread does not leave it pinned.
+class affinity_guard
+{
+#ifdef __linux__
+	cpu_set_t set;
+	bool saved;
+#endif
+
+public:
+	affinity_guard()
+	{
+#ifdef __linux__
+		CPU_ZERO(&set);
+		saved = pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+	}
+
+	~affinity_guard()
+	{
+#ifdef __linux__
+		if (saved)
+			pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+	}
+
+	affinity_guard(const affinity_guard&) = delete;
+	affinity_guard &operator=(const affinity_guard&) = delete;
+};
+
+// The transparent huge page mode of the kernel ("always", "madvise" or
+// "never"), empty if it is unknown.
+inline std::string huge_page_mode()
+{
+	std::ifstream fin("/sys/kernel/mm/transparent_hugepage/enabled");
+	std::string line;
+	std::getline(fin, line);
+	const auto first = line.find('['), last = line.find(']');
+	return first == std::string::npos || last == std::string::npos ? "" : line.substr(first + 1, last - first - 1);
+}
+
+// A line describing the memory placement used by 'solution::parallel_map'.
+inline std::string placement_policy()
+{
+	const auto &topology = numa_topology::get();
+	const auto mode = huge_page_mode();
+	std::ostringstream out;
+	if (topology.nodes.size() > 1)
+		out << topology.nodes.size() << " NUMA nodes, members replicated per node, threads pinned, output tiles first-touched by their node";
+	else
+		out << "1 NUMA node, shared members, threads not pinned";
+	out << "; huge pages: " << (mode.empty() ? "unavailable" : mode == "never" ? "disabled by the kernel" : mode);
+	return out.str();
+}
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include <cmath>
 #include <exception>
 #include <stdexcept>
+#include <vector>
+#include <map>
 
 #define SWAP(a, b) { auto t = a; a = b; b = t; }
 //#define SWAP_INT(a, b) { (a) ^= (b); (b) ^= (a); (a) ^= (b); }
@@ -15,7 +17,7 @@ const float       Ef = 2.718282F;
 const double      E  = 2.7182818284590452;
 const long double El = 2.71828182845904523536028747135266250L;
 
-double EPSILON = 1e-10;
+inline constexpr double EPSILON = 1e-10;
 
 template<typename T, typename U>
 constexpr inline T round_to(const U arg)
@@ -192,6 +194,95 @@ void delete_dublicates(std::vector<T> &array, const comparator_t equal)
     array.resize(new_size);
 }
 
+// The same as 'delete_dublicates(array, equal)' for 'equal' elements which
+// have keys at the distance at most 'window': the elements are compared
+// only with the kept elements which have close keys.
+template<typename T, typename key_t, typename comparator_t>
+void delete_dublicates(
+	std::vector<T> &array,
+	const key_t key,
+	const double window,
+	const comparator_t equal
+) {
+	std::multimap<double, std::size_t> kept;
+	std::size_t new_size = 0;
+	for (std::size_t i = 0; i < array.size(); ++i)
+	{
+		const double k = key(array[i]);
+		bool found = false;
+		for (
+			auto it = kept.lower_bound(k - window);
+			it != kept.end() && it->first <= k + window;
+			++it
+		)
+			if (equal(array[i], array[it->second]))
+			{
+				found = true;
+				break;
+			}
+		if (!found)
+		{
+			kept.emplace(k, new_size);
+			array[new_size++] = array[i];
+		}
+	}
+	array.resize(new_size);
+}
+
+// The Levin u-transform (beta = 1) of the partial sums s[first..n] with the
+// terms a_j = s_j - s_{j-1} (a_0 = s_0): the estimate of the limit of the
+// order n - first. The sums are cut before the first zero term.
+template<typename T>
+T levin_u(const std::vector<T> &s, const std::size_t first = 0)
+{
+	std::size_t n = first;
+	while (n + 1 < s.size() && s[n + 1] != s[n])
+		++n;
+	if (first == 0 && s[0] == T(0))
+		return s[0];
+	using real = decltype(std::abs(T()));
+	const std::size_t k = n - first;
+	T num = 0, den = 0;
+	real binomial = 1;
+	for (std::size_t j = 0; j <= k; ++j)
+	{
+		const std::size_t i = first + j;
+		const T a = i == 0 ? s[0] : s[i] - s[i - 1];
+		const real ratio = (real)(1 + i) / (real)(1 + n);
+		const T w = (j % 2 ? -binomial : binomial) * std::pow(ratio, (real)k - 1) / ((real)(1 + i) * a);
+		num += w * s[i];
+		den += w;
+		binomial = binomial * (real)(k - j) / (real)(j + 1);
+	}
+	return num / den;
+}
+
+// The Wynn epsilon algorithm on the partial sums s: the last element of the
+// last even column of the table. A zero difference ends the table.
+template<typename T>
+T wynn_epsilon(const std::vector<T> &s)
+{
+	std::vector<T> previous(s.size() + 1, T(0)), current = s, next;
+	T result = s.back();
+	for (std::size_t k = 1; current.size() > 1; ++k)
+	{
+		next.resize(current.size() - 1);
+		for (std::size_t i = 0; i < next.size(); ++i)
+		{
+			const T d = current[i + 1] - current[i];
+			if (d == T(0))
+				return result;
+			next[i] = previous[i + 1] + T(1) / d;
+		}
+		if (k % 2 == 0)
+			result = next.back();
+		previous = std::move(current);
+		current = std::move(next);
+		next.clear();
+	}
+	return result;
+}
+
 template<typename T>
 constexpr T int_pow(T base, const int exp)
 {
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <complex>
+#include <string>
+#include <fstream>
+#include "linear_fractional_transformation.hpp"
+#include "solution.hpp"
+
+using problem_transform = linear_fractional_transformation<std::complex<double>>;
+
+// The parameters which define the group and the series of a run.
+struct problem_key
+{
+	double tau;
+	triangle<double> tr;
+	std::complex<double> z_singular;
+	unsigned int level, m;
+};
+
+inline bool operator==(const problem_key &p, const problem_key &q)
+{
+	return
+		p.tau == q.tau && p.tr.A == q.tr.A && p.tr.B == q.tr.B && p.tr.C == q.tr.C &&
+		p.z_singular == q.z_singular && p.level == q.level && p.m == q.m;
+}
+
+inline bool read_problem(const std::string &file, problem_key &key)
+{
+	std::ifstream fin(file);
+	return (bool)(fin >> key.tau >> key.tr >> key.z_singular >> key.level >> key.m);
+}
+
+// The transformation P of the problem and the functions h1, h2 of the
+// series: h1 has its pole at the singular point, h2 is the identity.
+inline void problem_transforms(
+	const problem_key &key,
+	problem_transform &P,
+	problem_transform &H1,
+	problem_transform &H2
+) {
+	P = problem_transform(2. + 7.i, 9., 6.i, 11.);
+	H1 = problem_transform(0., 1., 1., -inverse(P)((key.z_singular - key.tr.A) / (key.tr.B - key.tr.A)));
+	H2 = problem_transform();
+}
\ No newline at end of file
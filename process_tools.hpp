@@ -0,0 +1,120 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+struct child_process
+{
+	pid_t pid;
+	int in, out;
+
+	child_process() : pid(-1), in(-1), out(-1) {}
+};
+
+inline std::string self_executable(const char *fallback)
+{
+	char buffer[PATH_MAX];
+	const auto len = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+	if (len <= 0)
+		return fallback;
+	buffer[len] = '\0';
+	return buffer;
+}
+
+// Starts 'args[0]' with 'args' as its argument list; the standard input and
+// output of the child are connected to the pipes 'in' and 'out'. The pipes
+// are close-on-exec, so children spawned concurrently do not inherit them.
+inline child_process spawn_process(const std::vector<std::string> &args)
+{
+	std::vector<char*> argv;
+	for (const auto &arg : args)
+		argv.push_back(const_cast<char*>(arg.c_str()));
+	argv.push_back(nullptr);
+
+	int in[2], out[2];
+	if (pipe2(in, O_CLOEXEC) != 0)
+		throw std::runtime_error(std::string("pipe: ") + std::strerror(errno));
+	if (pipe2(out, O_CLOEXEC) != 0)
+	{
+		close(in[0]); close(in[1]);
+		throw std::runtime_error(std::string("pipe: ") + std::strerror(errno));
+	}
+
+	child_process child;
+	child.pid = fork();
+	if (child.pid < 0)
+	{
+		close(in[0]); close(in[1]);
+		close(out[0]); close(out[1]);
+		throw std::runtime_error(std::string("fork: ") + std::strerror(errno));
+	}
+	if (child.pid == 0)
+	{
+		dup2(in[0], STDIN_FILENO);
+		dup2(out[1], STDOUT_FILENO);
+		close(in[0]); close(in[1]);
+		close(out[0]); close(out[1]);
+		execvp(argv[0], argv.data());
+		_exit(127);
+	}
+
+	close(in[0]);
+	close(out[1]);
+	child.in = in[1];
+	child.out = out[0];
+	return child;
+}
+
+inline child_process spawn_shell(const std::string &command)
+{
+	return spawn_process({ "/bin/sh", "-c", command });
+}
+
+inline void write_all(const int fd, const char *data, std::size_t size)
+{
+	while (size > 0)
+	{
+		const auto n = write(fd, data, size);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			throw std::runtime_error(std::string("write: ") + std::strerror(errno));
+		}
+		data += n;
+		size -= n;
+	}
+}
+
+inline std::size_t read_some(const int fd, char *data, const std::size_t size)
+{
+	for (;;)
+	{
+		const auto n = read(fd, data, size);
+		if (n >= 0)
+			return n;
+		if (errno != EINTR)
+			throw std::runtime_error(std::string("read: ") + std::strerror(errno));
+	}
+}
+
+inline int wait_process(child_process &child)
+{
+	if (child.in >= 0) { close(child.in); child.in = -1; }
+	if (child.out >= 0) { close(child.out); child.out = -1; }
+
+	int status = 0;
+	while (waitpid(child.pid, &status, 0) < 0)
+		if (errno != EINTR)
+			throw std::runtime_error(std::string("waitpid: ") + std::strerror(errno));
+	child.pid = -1;
+	return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+// What 'solution' has to know about a series engine. An engine which walks
+// the group is built from the generators and the tree of the shortest words
+// instead of a list of members, and sums the words of every length itself.
+template<class series_t>
+struct series_traits
+{
+	static constexpr bool walks_words = false;
+};
\ No newline at end of file
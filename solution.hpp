@@ -5,10 +5,20 @@
 #include <vector>
 #include <cmath>
 #include <thread>
+#include <atomic>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <memory>
+#include <mutex>
 #include "linear_fractional_transformation.hpp"
 #include "theta_series.hpp"
+#include "word_tree_theta_series.hpp"
+#include "series_traits.hpp"
+#include "fast_complex.hpp"
 #include "numeric_tools.hpp"
 #include "io_tools.hpp"
+#include "memory_tools.hpp"
 
 using namespace std::complex_literals;
 
@@ -34,7 +44,15 @@ std::istream &operator>>(std::istream &in, triangle<T> &tr)
 	return in >> tr.A >> tr.B >> tr.C;
 }
 
-template<class real>
+enum extrapolation_t { LEVIN, WYNN };
+
+// The group is built and the points are given in 'std::complex', the series
+// are summed in 'complex_t' (e.g. 'fast_complex').
+template<
+	class real,
+	template<class> class series_t = theta_series,
+	template<class> class complex_t = std::complex
+>
 class solution
 {
 private:
@@ -42,11 +60,76 @@ private:
 
 	using complex = std::complex<real>;
 	using transform = linear_fractional_transformation<complex>;
+	using normalized = normalized_transformation<complex>;
+	using kernel = complex_t<real>;
+	using kernel_transform = linear_fractional_transformation<kernel>;
+	using series = series_t<kernel>;
+	
+	// A word of the group BFS: its element, its length, its last letter and
+	// the kept word it is made from.
+	struct word_t
+	{
+		normalized g;
+		std::size_t length;
+		flag_t last;
+		std::size_t prefix;
+	};
+	
+	// The copies of th1, th2 for the NUMA nodes. The copy of a node is made
+	// by the first thread of parallel_map placed on it and kept until the
+	// next build; copies of the solution share them.
+	struct replicas_t
+	{
+		std::vector<std::once_flag> made;
+		std::vector<std::unique_ptr<const std::pair<series, series>>> copies;
+		
+		explicit replicas_t(const std::size_t nodes) : made(nodes), copies(nodes) {}
+	};
 	
 	complex a, b;
 	real tau;
-	transform P;
-	theta_series<complex> th1, th2;
+	transform P, invP;
+	std::vector<transform> G;
+	// The ends of the members of the words up to each length in 'G'.
+	std::vector<std::size_t> shells;
+	series th1, th2;
+	std::shared_ptr<replicas_t> replicas;
+
+	// The series are built over g * P^-1 instead of g, so they take the
+	// points before P^-1 is applied. Every term gains the factor
+	// (gamma w + delta)^-2m of the bottom row of P^-1, which is common to
+	// th1 and th2 at a point and cancels in their ratio.
+	void __build__(
+		const unsigned int m,
+		const transform &h1,
+		const transform &h2
+	) {
+		invP = inverse_matrix(P);
+		std::vector<kernel_transform> folded;
+		folded.reserve(G.size());
+		for (const auto &g : G)
+			folded.emplace_back(g * invP);
+		th1.build(m, kernel_transform(h1), folded);
+		th2.build(m, kernel_transform(h2), folded);
+		replicas = std::make_shared<replicas_t>(numa_topology::get().nodes.size());
+	}
+
+	// The series of the engines which walk the group get the generators and
+	// the tree of the words instead of the members, and 'G' is left empty.
+	void __build__(
+		const unsigned int m,
+		const transform &h1,
+		const transform &h2,
+		const std::vector<kernel_transform> &letters,
+		const std::vector<std::pair<std::size_t, std::size_t>> &tree
+	) {
+		G.clear();
+		G.shrink_to_fit();
+		shells.clear();
+		th1.build(m, kernel_transform(h1), letters, kernel_transform(invP), tree);
+		th2.build(m, kernel_transform(h2), letters, kernel_transform(invP), tree);
+		replicas = std::make_shared<replicas_t>(numa_topology::get().nodes.size());
+	}
 
 	void __build__(
 		const complex zeta,
@@ -67,73 +150,101 @@ private:
 		const auto a2 = (A2 - tau) / (1 - tau);
 		const auto b2 = B2 / (1 - tau);
 
-		const transform Id, T1(a1, b1, 0, 1), T2(a2, b2, 0, 1);
+		const transform T1(a1, b1, 0, 1), T2(a2, b2, 0, 1);
 
-		const auto invP = inverse_matrix(P);
+		invP = inverse_matrix(P);
 
-		const auto S1 = cancel_out(invP * T1 * P);
-		const auto S2 = cancel_out(invP * T2 * P);
-		const auto I1 = inverse(S1), I2 = inverse(S2);
+		const normalized Id, S1(invP * T1 * P), S2(invP * T2 * P);
+		const auto I1 = S1.inverse(), I2 = S2.inverse();
 
-		std::list<std::vector<transform>> data;
-
-		std::size_t len = 4;
-		data.push_back(std::vector<transform>({ Id, S1, S2, I1, I2 }));
-		std::vector<flag_t> flags = { GEN_1, GEN_2, INV_1, INV_2 };
-		std::vector<transform> dt;
-		std::vector<flag_t> fg;
-		for (unsigned int i = 0; i < level; ++i)
+		// The words with their lengths and last letters, the first word of an
+		// element is one of the shortest ones. The first shortest words are
+		// closed under taking prefixes, so only the kept words of a length are
+		// extended to the next one: the same words are kept, in the same order,
+		// as from all 4 * 3^level reduced words, and the work grows with the
+		// group.
+		std::vector<word_t> words = {
+			{ Id, 0, GEN_1, 0 }, { S1, 1, GEN_1, 0 }, { S2, 1, GEN_2, 0 }, { I1, 1, INV_1, 0 }, { I2, 1, INV_2, 0 }
+		};
+		const equal_vectors_fp equal(Euclidean_distance<complex, complex>);
+		const auto delete_words = [&words, &equal]()
+		{
+			delete_dublicates(
+				words,
+				[](const auto &w) { return w.g.key(); },
+				4 * EPSILON,
+				[&equal](const auto &u, const auto &v) { return equal(u.g, v.g); }
+			);
+		};
+		delete_words();
+		for (std::size_t length = 2, first = 1; length <= level + 1; ++length)
 		{
-			len *= 3;
-			dt.reserve(len);
-			fg.reserve(len);
-			std::size_t j = 0;
-			for (const auto e : data.back())
+			const std::size_t last = words.size();
+			for (std::size_t j = first; j < last; ++j)
 			{
-				switch (flags[j++])
+				const auto e = words[j].g;
+				switch (words[j].last)
 				{
 				case GEN_1:
-					dt.push_back(e * S1); fg.push_back(GEN_1);
-					dt.push_back(e * S2); fg.push_back(GEN_2);
-					dt.push_back(e * I2); fg.push_back(INV_2);
+					words.push_back({ e * S1, length, GEN_1, j });
+					words.push_back({ e * S2, length, GEN_2, j });
+					words.push_back({ e * I2, length, INV_2, j });
 					break;
 				
 				case GEN_2:
-					dt.push_back(e * S1); fg.push_back(GEN_1);
-					dt.push_back(e * S2); fg.push_back(GEN_2);
-					dt.push_back(e * I1); fg.push_back(INV_1);
+					words.push_back({ e * S1, length, GEN_1, j });
+					words.push_back({ e * S2, length, GEN_2, j });
+					words.push_back({ e * I1, length, INV_1, j });
 					break;
 				
 				case INV_1:
-					dt.push_back(e * S2); fg.push_back(GEN_2);
-					dt.push_back(e * I1); fg.push_back(INV_1);
-					dt.push_back(e * I2); fg.push_back(INV_2);
+					words.push_back({ e * S2, length, GEN_2, j });
+					words.push_back({ e * I1, length, INV_1, j });
+					words.push_back({ e * I2, length, INV_2, j });
 					break;
 				
 				case INV_2:
-					dt.push_back(e * S1); fg.push_back(GEN_1);
-					dt.push_back(e * I1); fg.push_back(INV_1);
-					dt.push_back(e * I2); fg.push_back(INV_2);
+					words.push_back({ e * S1, length, GEN_1, j });
+					words.push_back({ e * I1, length, INV_1, j });
+					words.push_back({ e * I2, length, INV_2, j });
 					break;
 				}
 			}
-			data.push_back(std::move(dt));
-			flags = std::move(fg);
-			dt.clear(); fg.clear();
+			delete_words();
+			first = last;
 		}
-		dt.reserve(1 + 4 * pow_sum(3, 0, level));
-		for (const auto &d : data)
-			dt.insert(dt.end(), d.begin(), d.end());
-		delete_dublicates(dt, equal_vectors_fp(Euclidean_distance<complex, complex>));
 		
-		/*typed_ofstream<transform> fout(
-			"group.dat", std::ios::out | std::ios::binary | std::ios::trunc
-		);
-		fout.write_vector(dt);
-		fout.close();//*/
+		// The engines which walk the group extend the elements on the left and
+		// the words are extended on the right, so they get the tree of the
+		// inverses, (w s)^-1 = s^-1 w^-1. The words up to a length are closed
+		// under inversion, so the inverses are the same elements. The words
+		// are freed before the series are built and 'G' is not filled.
+		if constexpr (series_traits<series>::walks_words)
+		{
+			std::vector<std::pair<std::size_t, std::size_t>> tree;
+			tree.reserve(words.size());
+			for (const auto &w : words)
+				tree.emplace_back(w.prefix, w.last);
+			words.clear();
+			words.shrink_to_fit();
+			__build__(
+				m, h1, h2,
+				{ kernel_transform(I1), kernel_transform(I2), kernel_transform(S1), kernel_transform(S2) },
+				tree
+			);
+			return;
+		}
 		
-		th1.build(m, h1, dt);
-		th2.build(m, h2, dt);
+		G.clear();
+		G.reserve(words.size());
+		shells.assign(level + 2, 0);
+		for (const auto &w : words)
+		{
+			G.push_back(w.g);
+			++shells[w.length];
+		}
+		std::partial_sum(shells.begin(), shells.end(), shells.begin());
+		__build__(m, h1, h2);
 	}
 	
 public:
@@ -153,6 +264,20 @@ public:
 		__build__(a * tr.C + b, level, m, h1, h2);
 	}
 
+	template<class T>
+	solution(
+		const real tt,
+		const triangle<T> &tr,
+		const transform &PP,
+		const std::vector<transform> &GG,
+		const unsigned int m,
+		const transform &h1,
+		const transform &h2
+	) : a((T)1 / (tr.B - tr.A)), b(tr.A / (tr.A - tr.B)), tau(tt), P(PP), G(GG), shells(1, GG.size())
+	{
+		__build__(m, h1, h2);
+	}
+
 	template<class T>
 	void build(
 		const real tt,
@@ -168,32 +293,273 @@ public:
 		tau = tt; P = PP;
 		__build__(a * tr.C + b, level, m, h1, h2);
 	}
+
+	template<class T>
+	void build(
+		const real tt,
+		const triangle<T> &tr,
+		const transform &PP,
+		const std::vector<transform> &GG,
+		const unsigned int m,
+		const transform &h1,
+		const transform &h2
+	) {
+		a = (T)1 / (tr.B - tr.A);
+		b = tr.A / (tr.A - tr.B);
+		tau = tt; P = PP; G = GG;
+		shells.assign(1, G.size());
+		__build__(m, h1, h2);
+	}
 	
 	inline std::size_t members_count() const
 	{
 		return th1.members_count();
 	}
 	
+	inline const std::vector<transform> &group() const
+	{
+		return G;
+	}
+	
 	complex operator()(const complex &z) const
 	{
 		const auto z_L = a * z + b;
 		
-		const auto z_c = std::conj(z_L);
-		const auto z_t = (z_L - tau * z_c) / (1 - tau);
+		const kernel z_c = std::conj(z_L);
+		const kernel z_t = (z_L - tau * std::conj(z_L)) / (1 - tau);
 		
-		const auto invP = inverse(P);
+		const auto th1_c = th1(z_c);
+		const auto th2_c = th2(z_c);
+		const auto th1_t = th1(z_t);
+		const auto th2_t = th2(z_t);
 		
-		const auto zeta_c = invP(z_c);
-		const auto zeta_t = invP(z_t);
+		return th1_t / th2_t - th1_c / th2_c;
+	}
+	
+	// Evaluates one point with the members split between threads. The members
+	// are summed in blocks of fixed size and the block sums are added in the
+	// order of the blocks, so the result does not depend on 'threads'.
+	complex parallel_evaluate(const complex &z, unsigned int threads = 0) const
+	{
+		const std::size_t block = 128;
+		
+		const auto z_L = a * z + b;
+		
+		const kernel z_c = std::conj(z_L);
+		const kernel z_t = (z_L - tau * std::conj(z_L)) / (1 - tau);
 		
-		const auto th1_c = th1(zeta_c);
-		const auto th2_c = th2(zeta_c);
-		const auto th1_t = th1(zeta_t);
-		const auto th2_t = th2(zeta_t);
+		const std::size_t count = th1.members_count();
+		const std::size_t blocks = (count + block - 1) / block;
+		
+		if (threads == 0)
+			threads = std::max(std::thread::hardware_concurrency(), 1U);
+		threads = (unsigned int)std::min<std::size_t>(threads, std::max<std::size_t>(blocks, 1));
+		
+		std::vector<std::array<kernel, 4>> sums(blocks);
+		std::atomic<std::size_t> next(0);
+		
+		const auto worker = [&]()
+		{
+			for (std::size_t k; (k = next.fetch_add(1)) < blocks;)
+			{
+				const std::size_t first = k * block, last = std::min(first + block, count);
+				sums[k] = {
+					th1(z_c, first, last),
+					th2(z_c, first, last),
+					th1(z_t, first, last),
+					th2(z_t, first, last)
+				};
+			}
+		};
+		
+		std::vector<std::thread> pool;
+		for (unsigned int i = 1; i < threads; ++i)
+			pool.emplace_back(worker);
+		worker();
+		for (auto &thr : pool)
+			thr.join();
+		
+		kernel th1_c = 0, th2_c = 0, th1_t = 0, th2_t = 0;
+		for (const auto &s : sums)
+		{
+			th1_c += s[0];
+			th2_c += s[1];
+			th1_t += s[2];
+			th2_t += s[3];
+		}
 		
 		return th1_t / th2_t - th1_c / th2_c;
 	}
 	
+	// The partial sums of the series at the points over the words up to
+	// each length, 'sums[i][k]' is the one of the point i.
+	std::vector<std::vector<complex>> shell_sums(
+		const series &s,
+		const std::vector<complex> &zz
+	) const {
+		std::vector<std::vector<complex>> sums(zz.size());
+		if constexpr (series_traits<series>::walks_words)
+		{
+			const auto kernel_sums = s.shell_sums(std::vector<kernel>(zz.begin(), zz.end()));
+			for (std::size_t i = 0; i < zz.size(); ++i)
+				sums[i].assign(kernel_sums[i].begin(), kernel_sums[i].end());
+			return sums;
+		}
+		for (std::size_t i = 0; i < zz.size(); ++i)
+		{
+			sums[i].reserve(shells.size());
+			complex sum = 0;
+			std::size_t first = 0;
+			for (const auto last : shells)
+			{
+				sum += s(kernel(zz[i]), first, last);
+				sums[i].push_back(sum);
+				first = last;
+			}
+		}
+		return sums;
+	}
+	
+	// The value at z with every series summed by 'method' from its partial
+	// sums over the words up to each length, and the change of the value
+	// when the longest words are dropped as its error. The shells of the
+	// triangle groups alternate, so the sums are also taken every other
+	// length; the order and the step with the least change are used. The
+	// estimate is taken only when the change is within 'tolerance' of the
+	// value, otherwise the value is the plain sum and the error is the
+	// larger of the change and the one of the plain sum by the last shell.
+	// Without the lengths (the members are given) the value is the plain
+	// sum and the error is NaN.
+	std::pair<complex, real> extrapolate(const complex &z, const extrapolation_t method = LEVIN) const
+	{
+		std::vector<complex> values;
+		std::vector<real> errors;
+		extrapolate({ z }, values, errors, method);
+		return { values.front(), errors.front() };
+	}
+	
+	void extrapolate(
+		const std::vector<complex> &zz,
+		std::vector<complex> &values,
+		std::vector<real> &errors,
+		const extrapolation_t method = LEVIN
+	) const {
+		const std::size_t max_order = 4;
+		const real tolerance = 1e-3;
+		
+		const std::size_t len = zz.size();
+		std::vector<complex> z_c(len), z_t(len);
+		for (std::size_t i = 0; i < len; ++i)
+		{
+			const auto z_L = a * zz[i] + b;
+			z_c[i] = std::conj(z_L);
+			z_t[i] = (z_L - tau * z_c[i]) / (1 - tau);
+		}
+		
+		const std::array<std::vector<std::vector<complex>>, 4> sums = {
+			shell_sums(th1, z_c),
+			shell_sums(th2, z_c),
+			shell_sums(th1, z_t),
+			shell_sums(th2, z_t)
+		};
+		
+		values.resize(len);
+		errors.resize(len);
+		for (std::size_t i = 0; i < len; ++i)
+		{
+			const std::size_t count = sums[0][i].size();
+			
+			// The estimate from the sums [0, n) taken with 'step' up to the
+			// last one, by the transformation of the 'order'.
+			const auto estimate = [&](const std::size_t n, const std::size_t step, const std::size_t order)
+			{
+				std::array<complex, 4> e;
+				for (std::size_t k = 0; k < 4; ++k)
+				{
+					std::vector<complex> s;
+					for (std::size_t j = (n - 1) % step; j < n; j += step)
+						s.push_back(sums[k][i][j]);
+					e[k] = method == WYNN
+						? wynn_epsilon(std::vector<complex>(s.end() - std::min(s.size(), 2 * order + 1), s.end()))
+						: levin_u(s, s.size() - 1 - order);
+				}
+				return e[2] / e[3] - e[0] / e[1];
+			};
+			
+			// The plain sum over the words up to the length n.
+			const auto plain = [&](const std::size_t n)
+			{
+				return sums[2][i][n - 1] / sums[3][i][n - 1] - sums[0][i][n - 1] / sums[1][i][n - 1];
+			};
+			
+			values[i] = plain(count);
+			errors[i] = INFINITY;
+			if (count < 2)
+			{
+				errors[i] = NAN;
+				continue;
+			}
+			
+			complex best = values[i];
+			for (std::size_t step = 1; step <= 2; ++step)
+				for (std::size_t order = 1; order <= max_order && (order + 2) * step <= count; ++order)
+				{
+					const auto value = estimate(count, step, order);
+					const real error = std::abs(value - estimate(count - step, step, order));
+					if (error < errors[i])
+					{
+						best = value;
+						errors[i] = error;
+					}
+				}
+			if (errors[i] <= tolerance * std::abs(best))
+				values[i] = best;
+			else
+				errors[i] = std::isinf(errors[i])
+					? std::abs(values[i] - plain(count - 1))
+					: std::max(errors[i], std::abs(values[i] - plain(count - 1)));
+		}
+	}
+	
+	// Extrapolates the points between threads, a tile of points at a time.
+	template<class A>
+	void parallel_extrapolate(
+		const std::vector<complex> &zz,
+		std::vector<complex, A> &values,
+		std::vector<real> &errors,
+		const extrapolation_t method = LEVIN,
+		unsigned int threads = 0
+	) const {
+		const std::size_t tile = 64;
+		
+		if (threads == 0)
+			threads = std::max(std::thread::hardware_concurrency(), 1U);
+		
+		values.resize(zz.size());
+		errors.resize(zz.size());
+		std::atomic<std::size_t> next(0);
+		
+		const auto worker = [&]()
+		{
+			std::vector<complex> v;
+			std::vector<real> e;
+			for (std::size_t first; (first = next.fetch_add(tile)) < zz.size();)
+			{
+				const std::size_t last = std::min(first + tile, zz.size());
+				extrapolate(std::vector<complex>(zz.begin() + first, zz.begin() + last), v, e, method);
+				std::copy(v.begin(), v.end(), values.begin() + first);
+				std::copy(e.begin(), e.end(), errors.begin() + first);
+			}
+		};
+		
+		std::vector<std::thread> pool;
+		for (unsigned int i = 1; i < threads; ++i)
+			pool.emplace_back(worker);
+		worker();
+		for (auto &thr : pool)
+			thr.join();
+	}
+	
 	template<class U>
 	inline auto map(const U &zz) const
 	{
@@ -203,56 +569,105 @@ public:
 	}
 	
 	template<class U>
-	inline auto parallel_map(const U &zz) const
+	inline auto parallel_map(const U &zz, unsigned int threads = 0) const
 	{
-		const std::size_t len = zz.size();
-		const std::size_t div = 4;//std::sqrt(len);
-		const std::size_t quot = len / div;
-		const std::size_t rem = len % div;
+		U ww(zz.size());
+		parallel_map(zz.begin(), zz.size(), ww.begin(), threads);
+		return ww;
+	}
+	
+	// Maps 'len' points from 'zz' into 'ww', both are random access
+	// iterators (or pointers, e.g. into mapped files). On a NUMA machine the
+	// threads are pinned, each node works on its own copy of the members and
+	// first takes the tiles of its own contiguous part of the points, so
+	// untouched output pages are placed on that node. The calling thread
+	// takes part and gets its affinity back at the end. With one thread (e.g.
+	// the workers of a sweep or a pipeline, which bring their own threads)
+	// nothing is pinned or copied and the shared members are used.
+	template<class input_t, class output_t>
+	void parallel_map(
+		const input_t zz,
+		const std::size_t len,
+		const output_t ww,
+		unsigned int threads = 0
+	) const {
+		const std::size_t tile = 256;
+		
+		if (threads == 0)
+			threads = std::max(std::thread::hardware_concurrency(), 1U);
+		
+		const auto &topology = numa_topology::get();
+		const bool numa = topology.nodes.size() > 1 && threads > 1;
+		const std::size_t nodes = numa ? topology.nodes.size() : 1;
 		
-		U ww(len);
-		auto it_z = zz.begin(), it_w = ww.begin();
-		const auto invP = inverse(P);
+		std::vector<std::size_t> node_threads(nodes, 0);
+		for (unsigned int i = 0; i < threads; ++i)
+			++node_threads[numa ? topology.place(i, threads).first : 0];
 		
-		#define INNER_PARALLEL_MAP(count)															\
-		{																							\
-			U a1_c(count), a1_t(count);																\
-			for (																					\
-				auto it_zeta_c = a1_c.begin(), it_zeta_t = a1_t.begin();							\
-				it_zeta_c != a1_c.end();															\
-				++it_z, ++it_zeta_c, ++it_zeta_t													\
-			) {																						\
-				const auto z_L = a * *it_z + b;														\
-				const auto z_c = std::conj(z_L);													\
-				const auto z_t = (z_L - tau * z_c) / (1 - tau);										\
-																									\
-				*it_zeta_c = invP(z_c);																\
-				*it_zeta_t = invP(z_t);																\
-			}																						\
-																									\
-			U a2_c = a1_c, a2_t = a1_t;																\
-			std::thread thr1_c(theta_series<complex>::template transform<U>, &th1, std::ref(a1_c));	\
-			std::thread thr2_c(theta_series<complex>::template transform<U>, &th2, std::ref(a2_c));	\
-			std::thread thr1_t(theta_series<complex>::template transform<U>, &th1, std::ref(a1_t));	\
-			std::thread thr2_t(theta_series<complex>::template transform<U>, &th2, std::ref(a2_t));	\
-			thr1_c.join();																			\
-			thr2_c.join();																			\
-			thr1_t.join();																			\
-			thr2_t.join();																			\
-																									\
-			auto it_a1_c = a1_c.begin();															\
-			auto it_a2_c = a2_c.begin();															\
-			auto it_a1_t = a1_t.begin();															\
-			auto it_a2_t = a2_t.begin();															\
-			while (it_a1_c != a1_c.end())															\
-				*it_w++ = *it_a1_t++ / *it_a2_t++ - *it_a1_c++ / *it_a2_c++;						\
+		// The points [bounds[k], bounds[k + 1]) belong to the node 'k'.
+		std::vector<std::size_t> bounds(nodes + 1, 0);
+		for (std::size_t k = 0, sum = 0; k < nodes; ++k)
+		{
+			sum += node_threads[k];
+			bounds[k + 1] = std::min(len, (len * sum / threads + tile - 1) / tile * tile);
 		}
+		bounds[nodes] = len;
 		
-		for (std::size_t i = 0; i < div; ++i)
-			INNER_PARALLEL_MAP(quot);
+		std::vector<std::atomic<std::size_t>> next(nodes);
+		for (std::size_t k = 0; k < nodes; ++k)
+			next[k] = bounds[k];
 		
-		INNER_PARALLEL_MAP(rem)
+		const auto worker = [&](const unsigned int index)
+		{
+			std::size_t node = 0;
+			const series *s1 = &th1, *s2 = &th2;
+			if (numa)
+			{
+				const auto place = topology.place(index, threads);
+				node = place.first;
+				pin_thread(place.second);
+				auto &copy = replicas->copies[node];
+				std::call_once(replicas->made[node], [&]() { copy = std::make_unique<const std::pair<series, series>>(th1, th2); });
+				s1 = &copy->first;
+				s2 = &copy->second;
+			}
+			
+			std::vector<kernel> a1_c, a1_t, a2_c, a2_t;
+			for (std::size_t k = 0; k < nodes; ++k)
+			{
+				const std::size_t part = (node + k) % nodes, last = bounds[part + 1];
+				for (std::size_t first; (first = next[part].fetch_add(tile)) < last;)
+				{
+					const std::size_t count = std::min(tile, last - first);
+					a1_c.resize(count);
+					a1_t.resize(count);
+					for (std::size_t i = 0; i < count; ++i)
+					{
+						const auto z_L = a * zz[first + i] + b;
+						a1_c[i] = std::conj(z_L);
+						a1_t[i] = (z_L - tau * std::conj(z_L)) / (1 - tau);
+					}
+					
+					a2_c = a1_c; a2_t = a1_t;
+					s1->transform(a1_c);
+					s2->transform(a2_c);
+					s1->transform(a1_t);
+					s2->transform(a2_t);
+					
+					for (std::size_t i = 0; i < count; ++i)
+						ww[first + i] = a1_t[i] / a2_t[i] - a1_c[i] / a2_c[i];
+				}
+			}
+		};
 		
-		return ww;
+		std::vector<std::thread> pool;
+		for (unsigned int i = 1; i < threads; ++i)
+			pool.emplace_back(worker, i);
+		{
+			const affinity_guard caller;
+			worker(0);
+		}
+		for (auto &thr : pool)
+			thr.join();
 	}
 };
\ No newline at end of file
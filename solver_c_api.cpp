@@ -0,0 +1,79 @@
+#include <complex>
+#include <memory>
+#include "solver_c_api.h"
+#include "solution.hpp"
+#include "problem.hpp"
+
+struct theta_solver
+{
+	solution<double> f;
+};
+
+extern "C" theta_solver *theta_solver_create(
+	const double tau,
+	const double triangle_[6],
+	const double z_singular[2],
+	const unsigned int level,
+	const unsigned int m
+) {
+	try
+	{
+		problem_key key;
+		key.tau = tau;
+		key.tr = triangle<double>(
+			{ triangle_[0], triangle_[1] },
+			{ triangle_[2], triangle_[3] },
+			{ triangle_[4], triangle_[5] }
+		);
+		key.z_singular = { z_singular[0], z_singular[1] };
+		key.level = level;
+		key.m = m;
+
+		problem_transform P, H1, H2;
+		problem_transforms(key, P, H1, H2);
+
+		auto solver = std::make_unique<theta_solver>();
+		solver->f.build(key.tau, key.tr, P, key.level, key.m, H1, H2);
+		return solver.release();
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+extern "C" int theta_solver_evaluate(
+	const theta_solver *solver,
+	const double *points,
+	const size_t count,
+	double *values,
+	const unsigned int threads
+) {
+	if (solver == nullptr || (count > 0 && (points == nullptr || values == nullptr)))
+		return 1;
+	try
+	{
+		// Tiles are read before they are written, so in-place evaluation is safe.
+		solver->f.parallel_map(
+			reinterpret_cast<const std::complex<double>*>(points),
+			count,
+			reinterpret_cast<std::complex<double>*>(values),
+			threads
+		);
+		return 0;
+	}
+	catch (...)
+	{
+		return 1;
+	}
+}
+
+extern "C" size_t theta_solver_members_count(const theta_solver *solver)
+{
+	return solver == nullptr ? 0 : solver->f.members_count();
+}
+
+extern "C" void theta_solver_destroy(theta_solver *solver)
+{
+	delete solver;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef SOLVER_C_API_H
+#define SOLVER_C_API_H
+
+#include <stddef.h>
+
+/* The library is built with -fvisibility=hidden and solver_c_api.map, only
+   these functions are exported. */
+#if defined(__GNUC__)
+#define THETA_SOLVER_API __attribute__((visibility("default")))
+#else
+#define THETA_SOLVER_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A solution built for one problem. Complex numbers are pairs of doubles
+   (real part, imaginary part), as 'double _Complex' and
+   'std::complex<double>' are laid out. */
+typedef struct theta_solver theta_solver;
+
+/* Builds the group and the series of the problem: 'triangle' holds the
+   vertices A, B, C, 'z_singular' is the singular point. Returns NULL if the
+   solution cannot be built. */
+THETA_SOLVER_API theta_solver *theta_solver_create(
+	double tau,
+	const double triangle[6],
+	const double z_singular[2],
+	unsigned int level,
+	unsigned int m
+);
+
+/* Evaluates the solution at 'count' points into 'values' (both arrays of
+   2 * count doubles, they may be the same array) with 'threads' threads,
+   0 is all hardware threads. Returns 0 on success. */
+THETA_SOLVER_API int theta_solver_evaluate(
+	const theta_solver *solver,
+	const double *points,
+	size_t count,
+	double *values,
+	unsigned int threads
+);
+
+THETA_SOLVER_API size_t theta_solver_members_count(const theta_solver *solver);
+
+THETA_SOLVER_API void theta_solver_destroy(theta_solver *solver);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <string>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <chrono>
+#include <algorithm>
+
+// Tasks with dependencies run by a pool of threads: a task may start as soon
+// as all of its dependencies are finished, of the ready tasks the one added
+// first starts first. The start and the finish of every task (in seconds
+// from the start of 'run') and the task which ran before it on its thread
+// are recorded, so the critical path of a run can be reported.
+class task_graph
+{
+public:
+	struct task_t
+	{
+		std::string stage;
+		std::function<void()> work;
+		std::vector<std::size_t> dependencies, dependents;
+		std::size_t left, previous;
+		double start, finish;
+	};
+
+	static const std::size_t NONE = (std::size_t)-1;
+
+private:
+	std::vector<task_t> tasks;
+
+public:
+	// Adds a task of the 'stage' which runs after the tasks 'dependencies'
+	// (added before it) and returns its index.
+	std::size_t add(
+		const std::string &stage,
+		const std::function<void()> &work,
+		const std::vector<std::size_t> &dependencies = {}
+	) {
+		const std::size_t index = tasks.size();
+		tasks.push_back({ stage, work, dependencies, {}, dependencies.size(), NONE, 0, 0 });
+		for (const auto d : dependencies)
+			tasks[d].dependents.push_back(index);
+		return index;
+	}
+
+	inline std::size_t size() const
+	{
+		return tasks.size();
+	}
+
+	inline const task_t &operator[](const std::size_t index) const
+	{
+		return tasks[index];
+	}
+
+	// Runs the tasks with 'threads' threads. The first exception of a task
+	// stops the scheduling of new tasks and is rethrown.
+	void run(unsigned int threads = 0)
+	{
+		if (threads == 0)
+			threads = std::max(std::thread::hardware_concurrency(), 1U);
+
+		std::priority_queue<std::size_t, std::vector<std::size_t>, std::greater<std::size_t>> ready;
+		for (std::size_t i = 0; i < tasks.size(); ++i)
+			if (tasks[i].left == 0)
+				ready.push(i);
+		std::size_t finished = 0;
+		std::exception_ptr error;
+		std::mutex mutex;
+		std::condition_variable changed;
+		const auto start = std::chrono::steady_clock::now();
+		const auto now = [start]()
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		};
+
+		const auto worker = [&]()
+		{
+			std::size_t last = NONE;
+			std::unique_lock<std::mutex> lock(mutex);
+			for (;;)
+			{
+				changed.wait(lock, [&]() { return !ready.empty() || finished == tasks.size() || error; });
+				if (finished == tasks.size() || error)
+					break;
+				const std::size_t i = ready.top();
+				ready.pop();
+				lock.unlock();
+				tasks[i].previous = last;
+				last = i;
+				tasks[i].start = now();
+				try
+				{
+					tasks[i].work();
+				}
+				catch (...)
+				{
+					lock.lock();
+					if (!error)
+						error = std::current_exception();
+					changed.notify_all();
+					break;
+				}
+				tasks[i].finish = now();
+				lock.lock();
+				++finished;
+				for (const auto d : tasks[i].dependents)
+					if (--tasks[d].left == 0)
+						ready.push(d);
+				changed.notify_all();
+			}
+		};
+
+		std::vector<std::thread> pool;
+		for (unsigned int i = 1; i < threads; ++i)
+			pool.emplace_back(worker);
+		worker();
+		for (auto &thr : pool)
+			thr.join();
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	// The chain of tasks which ends with the last finished one: the task
+	// before a task is the last finished of its dependencies and of the task
+	// which ran before it on its thread, that is what it waited for.
+	std::vector<std::size_t> critical_path() const
+	{
+		std::vector<std::size_t> path;
+		if (tasks.empty())
+			return path;
+		std::size_t i = std::max_element(tasks.begin(), tasks.end(),
+			[](const task_t &x, const task_t &y) { return x.finish < y.finish; }) - tasks.begin();
+		while (i != NONE)
+		{
+			path.push_back(i);
+			std::size_t before = tasks[i].previous;
+			for (const auto d : tasks[i].dependencies)
+				if (before == NONE || tasks[d].finish > tasks[before].finish)
+					before = d;
+			i = before;
+		}
+		std::reverse(path.begin(), path.end());
+		return path;
+	}
+};
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
 #include "linear_fractional_transformation.hpp"
 #include "numeric_tools.hpp"
+#include "memory_tools.hpp"
 
 template<class T>
 class theta_series
@@ -19,10 +21,57 @@ private:
 		) : f(ff), c(cc), d(dd) {}
 	};
 
-	std::vector<member_t> members;
+	huge_page_vector<member_t> members;
 
 	unsigned int m;
 
+	struct tiling_t
+	{
+		std::size_t points, members;
+	};
+
+	// Points are processed in tiles against tiles of members, so that a tile
+	// of members stays in cache while it is applied to all points of the tile.
+	// Each point sums the members in the same order as 'operator()' does.
+	template<class U>
+	void __transform__(U &zz, const tiling_t &tiling) const
+	{
+		const std::size_t len = zz.size(), count = members.size();
+		std::vector<T> w(tiling.points);
+		for (std::size_t p = 0; p < len; p += tiling.points)
+		{
+			const std::size_t p_last = std::min(p + tiling.points, len);
+			std::fill(w.begin(), w.end(), T(0));
+			for (std::size_t k = 0; k < count; k += tiling.members)
+			{
+				const std::size_t k_last = std::min(k + tiling.members, count);
+				for (std::size_t i = p; i < p_last; ++i)
+				{
+					const auto z = zz[i];
+					auto s = w[i - p];
+					for (std::size_t j = k; j < k_last; ++j)
+					{
+						const auto &member = members[j];
+						s += member.f(z) * int_pow(member.c * z + member.d, -2 * m);
+					}
+					w[i - p] = s;
+				}
+			}
+			for (std::size_t i = p; i < p_last; ++i)
+				zz[i] = w[i - p];
+		}
+	}
+
+	// A tile of members takes half of L2, so it stays there while the points
+	// of a tile are summed over it. The tiles are sized once from the cache:
+	// timing candidates cost more than the blocking saves at the sizes of
+	// the example problems.
+	static const tiling_t &tiling()
+	{
+		static const tiling_t t = { 16, std::max<std::size_t>(l2_cache_size() / 2 / sizeof(member_t), 1) };
+		return t;
+	}
+
 public:
 	theta_series() : m(0), members(0) {}
 
@@ -58,6 +107,19 @@ public:
 		return w;
 	}
 
+	// The partial sum over the members [first, last).
+	template<class U>
+	inline auto operator()(const U z, const std::size_t first, const std::size_t last) const
+	{
+		decltype(members.front().c * z) w = 0;
+		for (std::size_t j = first; j < last; ++j)
+		{
+			const auto &member = members[j];
+			w += member.f(z) * int_pow(member.c * z + member.d, -2 * m);
+		}
+		return w;
+	}
+
 	template<class U>
 	inline auto map(const U &zz) const
 	{
@@ -66,10 +128,15 @@ public:
 		return ww;
 	}
 	
+	// Members which fit in L2 stay there for every point and are not blocked.
 	template<class U>
 	inline auto transform(U &zz) const
 	{
-		for (auto &z : zz) z = operator()(z);
+		const auto &t = tiling();
+		if (members.size() <= 2 * t.members)
+			__transform__(zz, { 1, std::max<std::size_t>(members.size(), 1) });
+		else
+			__transform__(zz, t);
 		return zz;
 	}
 	
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include "numeric_tools.hpp"
+
+inline void write_big_endian(std::ostream &out, const float x)
+{
+	std::uint32_t w;
+	std::memcpy(&w, &x, sizeof(w));
+	const char bytes[4] = { (char)(w >> 24), (char)(w >> 16), (char)(w >> 8), (char)w };
+	out.write(bytes, 4);
+}
+
+// Writes the values on the mesh as a binary legacy VTK structured grid with
+// the point scalars 'magnitude' and 'phase'. The values follow each other
+// with y changing fastest, as the mesh is generated.
+template<class real, class A>
+bool write_vtk(
+	const std::string &file,
+	const real x_min, const real x_step, const std::size_t x_count,
+	const real y_min, const real y_step, const std::size_t y_count,
+	const std::vector<std::complex<real>, A> &values
+) {
+	std::ofstream out(file, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+		return false;
+
+	out
+		<< "# vtk DataFile Version 3.0\n"
+		<< "values\n"
+		<< "BINARY\n"
+		<< "DATASET STRUCTURED_POINTS\n"
+		<< "DIMENSIONS " << x_count << ' ' << y_count << " 1\n"
+		<< "ORIGIN " << x_min << ' ' << y_min << " 0\n"
+		<< "SPACING " << x_step << ' ' << y_step << " 1\n"
+		<< "POINT_DATA " << x_count * y_count << '\n';
+
+	out << "SCALARS magnitude float 1\nLOOKUP_TABLE default\n";
+	for (std::size_t j = 0; j < y_count; ++j)
+		for (std::size_t i = 0; i < x_count; ++i)
+			write_big_endian(out, (float)std::abs(values[i * y_count + j]));
+	out << "\nSCALARS phase float 1\nLOOKUP_TABLE default\n";
+	for (std::size_t j = 0; j < y_count; ++j)
+		for (std::size_t i = 0; i < x_count; ++i)
+			write_big_endian(out, (float)std::arg(values[i * y_count + j]));
+	out << '\n';
+
+	return (bool)out;
+}
+
+struct image_t
+{
+	std::size_t width, height;
+	std::vector<float> data;
+
+	image_t() : width(0), height(0) {}
+
+	image_t(const std::size_t w, const std::size_t h) : width(w), height(h), data(w * h, NAN) {}
+
+	inline float &operator()(const std::size_t col, const std::size_t row)
+	{
+		return data[row * width + col];
+	}
+
+	inline float operator()(const std::size_t col, const std::size_t row) const
+	{
+		return data[row * width + col];
+	}
+};
+
+// Halves the image, a pixel is the mean of the finite pixels of its 2x2
+// block (NaN if there are none).
+inline image_t downsample(const image_t &image)
+{
+	image_t half((image.width + 1) / 2, (image.height + 1) / 2);
+	for (std::size_t row = 0; row < half.height; ++row)
+		for (std::size_t col = 0; col < half.width; ++col)
+		{
+			float sum = 0;
+			int count = 0;
+			for (std::size_t r = 2 * row; r < std::min(2 * row + 2, image.height); ++r)
+				for (std::size_t c = 2 * col; c < std::min(2 * col + 2, image.width); ++c)
+					if (std::isfinite(image(c, r)))
+					{
+						sum += image(c, r);
+						++count;
+					}
+			if (count > 0)
+				half(col, row) = sum / count;
+		}
+	return half;
+}
+
+// Writes the 'size' x 'size' tile of the image as a binary PGM, the range
+// [lo, hi] is mapped onto 1..255 and non-finite pixels are black.
+inline bool write_pgm_tile(
+	const std::string &file,
+	const image_t &image,
+	const std::size_t col, const std::size_t row, const std::size_t size,
+	const float lo, const float hi
+) {
+	const std::size_t
+		w = std::min(size, image.width - col),
+		h = std::min(size, image.height - row);
+
+	std::ofstream out(file, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+		return false;
+	out << "P5\n" << w << ' ' << h << "\n255\n";
+	std::vector<unsigned char> line(w);
+	for (std::size_t r = row; r < row + h; ++r)
+	{
+		for (std::size_t c = col; c < col + w; ++c)
+		{
+			const float x = image(c, r);
+			line[c - col] = std::isfinite(x)
+				? (unsigned char)(1 + std::round(254 * std::clamp((x - lo) / (hi - lo), 0.F, 1.F)))
+				: 0;
+		}
+		out.write((const char*)line.data(), w);
+	}
+	return (bool)out;
+}
+
+// Writes the levels of a tile pyramid of the magnitude (log10 scale) and of
+// the phase of the values into 'directory', zeros and non-finite values are
+// black. Level 0 is the full resolution, every next level halves the
+// previous one, the last one is a single tile. The tiles are
+// '<directory>/<magnitude|phase>/<level>/<col>_<row>.pgm', the rows of an
+// image go from the top (the largest y) to the bottom.
+template<class real, class A>
+bool write_pyramid(
+	const std::string &directory,
+	const std::size_t x_count,
+	const std::size_t y_count,
+	const std::vector<std::complex<real>, A> &values,
+	const std::size_t tile = 256
+) {
+	image_t magnitude(x_count, y_count), cosine(x_count, y_count), sine(x_count, y_count);
+	float lo = INFINITY, hi = -INFINITY;
+	for (std::size_t i = 0; i < x_count; ++i)
+		for (std::size_t j = 0; j < y_count; ++j)
+		{
+			const auto v = values[i * y_count + j];
+			const auto r = std::abs(v);
+			if (!std::isfinite(r))
+				continue;
+			const std::size_t row = y_count - 1 - j;
+			if (r > 0)
+			{
+				magnitude(i, row) = (float)std::log10(r);
+				cosine(i, row) = (float)(v.real() / r);
+				sine(i, row) = (float)(v.imag() / r);
+				lo = std::min(lo, magnitude(i, row));
+				hi = std::max(hi, magnitude(i, row));
+			}
+		}
+	if (!(lo < hi))
+		hi = lo + 1;
+
+	std::error_code error;
+	if (!std::filesystem::create_directories(directory, error) && error)
+		return false;
+	std::ofstream info(directory + "/pyramid.txt", std::ios::out | std::ios::trunc);
+	info << "tile " << tile << "\nmagnitude_log10 " << lo << ' ' << hi << '\n';
+
+	for (std::size_t level = 0;; ++level)
+	{
+		image_t phase(magnitude.width, magnitude.height);
+		for (std::size_t k = 0; k < phase.data.size(); ++k)
+			phase.data[k] = std::atan2(sine.data[k], cosine.data[k]);
+
+		const std::string
+			m_dir = directory + "/magnitude/" + std::to_string(level),
+			p_dir = directory + "/phase/" + std::to_string(level);
+		std::filesystem::create_directories(m_dir, error);
+		std::filesystem::create_directories(p_dir, error);
+		for (std::size_t row = 0; row < magnitude.height; row += tile)
+			for (std::size_t col = 0; col < magnitude.width; col += tile)
+			{
+				const std::string name =
+					"/" + std::to_string(col / tile) + "_" + std::to_string(row / tile) + ".pgm";
+				if (
+					!write_pgm_tile(m_dir + name, magnitude, col, row, tile, lo, hi) ||
+					!write_pgm_tile(p_dir + name, phase, col, row, tile, (float)-PI, (float)PI)
+				)
+					return false;
+			}
+		info << "level " << level << ' ' << magnitude.width << ' ' << magnitude.height << '\n';
+
+		if (magnitude.width <= tile && magnitude.height <= tile)
+			break;
+		magnitude = downsample(magnitude);
+		cosine = downsample(cosine);
+		sine = downsample(sine);
+	}
+
+	return (bool)info;
+}
\ No newline at end of file
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include "linear_fractional_transformation.hpp"
+#include "numeric_tools.hpp"
+#include "series_traits.hpp"
+
+// The same series as 'theta_series', but the members are not stored: the
+// elements are generated for every tile of points by a depth-first walk
+// over the tree of their shortest words, the element s * g is reached from
+// g by one letter s and
+//     zeta' = s(zeta),  J' = (c_s zeta + d_s) J,
+// where zeta = g(root(w)) and J = c_{g * root} w + d_{g * root}. A node of
+// the tree takes 8 bytes and a point O(depth) memory.
+//
+// The tree is made by 'solution::__build__' from the words of the group
+// BFS, so the elements are exactly those of the stored engines.
+template<class T>
+class word_tree_theta_series
+{
+private:
+	using real = decltype(std::abs(T()));
+	using transformation = linear_fractional_transformation<T>;
+
+	// The element of a node is letters[letter] times the element of its
+	// parent, 'depth' is the length of its word.
+	struct node_t
+	{
+		std::uint32_t parent;
+		unsigned char letter;
+		std::uint16_t depth;
+	};
+
+	std::vector<transformation> letters;
+	transformation root;
+	// In the depth-first order, the identity is the first one.
+	std::vector<node_t> nodes;
+	unsigned int depth;
+
+	transformation h;
+	unsigned int m;
+
+	inline auto term(const T zeta, const T jacobian) const
+	{
+		return h(zeta) * int_pow(jacobian, -2 * (int)m);
+	}
+
+	// Calls 'add(i, k, t)' with the term t of the point i for every node of
+	// [first, last) in the depth-first order, k is the depth of the node.
+	// The walk starts from the ancestors of 'first', so a range costs its
+	// length and not the nodes before it.
+	template<class U, class visitor_t>
+	void __walk__(const U &zz, const std::size_t first, const std::size_t last, const visitor_t &add) const
+	{
+		const std::size_t len = zz.size();
+		std::vector<std::vector<T>>
+			zeta(depth + 1, std::vector<T>(len)),
+			jacobian(depth + 1, std::vector<T>(len));
+		for (std::size_t i = 0; i < len; ++i)
+		{
+			zeta[0][i] = root(zz[i]);
+			jacobian[0][i] = root.c * zz[i] + root.d;
+		}
+
+		const auto step = [&](const node_t &node)
+		{
+			const auto &g = letters[node.letter];
+			const std::size_t k = node.depth;
+			for (std::size_t i = 0; i < len; ++i)
+			{
+				const T z = zeta[k - 1][i];
+				zeta[k][i] = g(z);
+				jacobian[k][i] = (g.c * z + g.d) * jacobian[k - 1][i];
+			}
+		};
+
+		std::vector<std::size_t> path;
+		for (std::size_t k = first; k > 0 && k < nodes.size();)
+			path.push_back(k = nodes[k].parent);
+		for (auto it = path.rbegin(); it != path.rend(); ++it)
+			if (*it > 0)
+				step(nodes[*it]);
+
+		for (std::size_t k = first; k < std::min(last, nodes.size()); ++k)
+		{
+			const auto &node = nodes[k];
+			if (k > 0)
+				step(node);
+			for (std::size_t i = 0; i < len; ++i)
+				add(i, node.depth, term(zeta[node.depth][i], jacobian[node.depth][i]));
+		}
+	}
+
+	template<class U>
+	void __sum__(U &zz, const std::size_t first, const std::size_t last) const
+	{
+		std::vector<T> w(zz.size(), 0);
+		__walk__(zz, first, last, [&w](const std::size_t i, const std::size_t, const T t) { w[i] += t; });
+		for (std::size_t i = 0; i < zz.size(); ++i)
+			zz[i] = w[i];
+	}
+
+public:
+	word_tree_theta_series() : depth(0), m(0) {}
+
+	// 'letters' generate the group, the element k > 0 of 'words' is
+	// letters[words[k].second] times the element words[k].first (which
+	// comes before it), the element 0 is the identity. Points are mapped by
+	// 'root' before the group acts on them.
+	template<class U>
+	void build(
+		const unsigned int mm,
+		const linear_fractional_transformation<U> &hh,
+		const std::vector<transformation> &ll,
+		const transformation &rr,
+		const std::vector<std::pair<std::size_t, std::size_t>> &words
+	) {
+		m = mm; h = hh;
+		letters = ll; root = rr;
+
+		const std::size_t count = words.size();
+		std::vector<std::size_t> first_child(count + 1, 0), children(count);
+		for (std::size_t k = 1; k < count; ++k)
+			++first_child[words[k].first + 1];
+		std::partial_sum(first_child.begin(), first_child.end(), first_child.begin());
+		{
+			auto next = first_child;
+			for (std::size_t k = 1; k < count; ++k)
+				children[next[words[k].first]++] = k;
+		}
+
+		nodes.clear();
+		depth = 0;
+		if (count == 0)
+			return;
+		if (count - 1 > UINT32_MAX)
+			throw std::length_error("word_tree_theta_series: too many elements for 32-bit parent indices");
+		nodes.reserve(count);
+		// The elements with the index of their parent in 'nodes'.
+		std::vector<std::pair<std::size_t, std::size_t>> stack = { { 0, 0 } };
+		while (!stack.empty())
+		{
+			const auto [k, parent] = stack.back();
+			stack.pop_back();
+			const std::size_t d = k == 0 ? 0 : nodes[parent].depth + 1;
+			if (d > UINT16_MAX)
+				throw std::length_error("word_tree_theta_series: words longer than 65535 letters");
+			nodes.push_back({ (std::uint32_t)parent, (unsigned char)(k == 0 ? 0 : words[k].second), (std::uint16_t)d });
+			depth = std::max<unsigned int>(depth, d);
+			const std::size_t index = nodes.size() - 1;
+			for (std::size_t j = first_child[k + 1]; j > first_child[k]; --j)
+				stack.emplace_back(children[j - 1], index);
+		}
+	}
+
+	// The series is defined by the generators, not by a list of members.
+	template<class U, class V>
+	void build(
+		const unsigned int,
+		const linear_fractional_transformation<U> &,
+		const std::vector<linear_fractional_transformation<V>> &
+	) {
+		throw std::logic_error("word_tree_theta_series is built from the generators of the group");
+	}
+
+	template<class U>
+	inline auto operator()(const U z) const
+	{
+		std::vector<T> zz = { z };
+		__sum__(zz, 0, nodes.size());
+		return zz.front();
+	}
+
+	// The partial sum over the members [first, last) in the order of the walk.
+	template<class U>
+	inline auto operator()(const U z, const std::size_t first, const std::size_t last) const
+	{
+		std::vector<T> zz = { z };
+		__sum__(zz, first, last);
+		return zz.front();
+	}
+
+	// The partial sums at every point over the elements of the depth at
+	// most k = 0..depth, 'sums[i][k]' is the one of the point i.
+	template<class U>
+	std::vector<std::vector<T>> shell_sums(const U &zz) const
+	{
+		std::vector<std::vector<T>> sums(zz.size(), std::vector<T>(depth + 1, 0));
+		__walk__(zz, 0, nodes.size(), [&sums](const std::size_t i, const std::size_t k, const T t) { sums[i][k] += t; });
+		for (auto &s : sums)
+			std::partial_sum(s.begin(), s.end(), s.begin());
+		return sums;
+	}
+
+	template<class U>
+	inline auto map(const U &zz) const
+	{
+		U ww = zz;
+		__sum__(ww, 0, nodes.size());
+		return ww;
+	}
+
+	template<class U>
+	inline auto transform(U &zz) const
+	{
+		__sum__(zz, 0, nodes.size());
+		return zz;
+	}
+
+	inline std::size_t members_count() const
+	{
+		return nodes.size();
+	}
+};
+
+template<class T>
+struct series_traits<word_tree_theta_series<T>>
+{
+	static constexpr bool walks_words = true;
+};
\ No newline at end of file